@@ -0,0 +1,225 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "mem.h"
+#include "sim.h"
+
+#define MAGIC "LIFECKP1"
+
+typedef struct {
+    CheckpointHeader header;
+    unsigned char *cells;
+} Snapshot;
+
+static const char *checkpointPath = NULL;
+static char *tempPath = NULL;
+static size_t cellBytes = 0;
+static Snapshot slots[2];
+
+/* Slot the writer is busy with and slot waiting for it, -1 for none. Guarded by lock. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static pthread_t writer;
+static int writing = -1;
+static int pending = -1;
+static int stopping = 0;
+
+static size_t rowBytes(int width) {
+    return ((size_t)width + 3) / 4;
+}
+
+static int readFile(const char *path, unsigned char **data, size_t *size) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    *size = st.st_size;
+    *data = *size ? mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (*data == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", path, *size ? strerror(errno) : "empty file");
+        return -1;
+    }
+    return 0;
+}
+
+static int checkHeader(const char *path, const CheckpointHeader *header, size_t size) {
+    if (size < sizeof(CheckpointHeader) || memcmp(header->magic, MAGIC, 8) != 0) {
+        fprintf(stderr, "%s: not a checkpoint\n", path);
+        return -1;
+    }
+    if (header->width < 1 || header->width > MAX_FIELD_SIZE || header->height < 1 || header->height > MAX_FIELD_SIZE ||
+        size != sizeof(CheckpointHeader) + rowBytes(header->width) * header->height) {
+        fprintf(stderr, "%s: damaged checkpoint\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int checkpointReadHeader(const char *path, CheckpointHeader *header) {
+    unsigned char *data;
+    size_t size;
+    int result;
+    if (readFile(path, &data, &size) != 0) {
+        return -1;
+    }
+    result = checkHeader(path, (const CheckpointHeader *)data, size);
+    if (result == 0) {
+        memcpy(header, data, sizeof(CheckpointHeader));
+        header->rule[sizeof(header->rule) - 1] = '\0';
+    }
+    munmap(data, size);
+    return result;
+}
+
+int checkpointRestore(const char *path, const Engine *engine, void *field, unsigned char *row, long long *generation) {
+    unsigned char *data;
+    size_t size;
+    int x, y;
+    if (readFile(path, &data, &size) != 0) {
+        return -1;
+    }
+    const CheckpointHeader *header = (const CheckpointHeader *)data;
+    if (checkHeader(path, header, size) != 0) {
+        munmap(data, size);
+        return -1;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    const unsigned char *cells = data + sizeof(CheckpointHeader);
+    for (y = 0; y < header->height; y++) {
+        const unsigned char *packed = cells + rowBytes(header->width) * y;
+        for (x = 0; x < header->width; x++) {
+            row[x] = (packed[x >> 2] >> ((x & 3) * 2)) & 3;
+        }
+        engine->writeRow(field, y, row);
+    }
+    *generation = header->generation;
+    munmap(data, size);
+    return 0;
+}
+
+static int writeSnapshot(const Snapshot *s) {
+    size_t size = sizeof(CheckpointHeader) + cellBytes;
+    int fd = open(tempPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    unsigned char *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    memcpy(data, &s->header, sizeof(CheckpointHeader));
+    memcpy(data + sizeof(CheckpointHeader), s->cells, cellBytes);
+    int result = msync(data, size, MS_SYNC);
+    munmap(data, size);
+    if (result != 0) {
+        return -1;
+    }
+    return rename(tempPath, checkpointPath);
+}
+
+static void *writerMain(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    while (1) {
+        while (pending < 0 && !stopping) {
+            pthread_cond_wait(&wake, &lock);
+        }
+        if (pending < 0) {
+            break;
+        }
+        writing = pending;
+        pending = -1;
+        pthread_mutex_unlock(&lock);
+
+        if (writeSnapshot(&slots[writing]) != 0) {
+            fprintf(stderr, "%s: checkpoint failed: %s\n", checkpointPath, strerror(errno));
+        }
+
+        pthread_mutex_lock(&lock);
+        writing = -1;
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+void checkpointStart(const char *path, int width, int height) {
+    int i;
+    checkpointPath = path;
+    tempPath = malloc(strlen(path) + 5);
+    sprintf(tempPath, "%s.tmp", path);
+    cellBytes = rowBytes(width) * height;
+    for (i = 0; i < 2; i++) {
+        memset(&slots[i].header, 0, sizeof(CheckpointHeader));
+        memcpy(slots[i].header.magic, MAGIC, 8);
+        slots[i].header.width = width;
+        slots[i].header.height = height;
+        slots[i].header.seed = lifeOptions.seed;
+        snprintf(slots[i].header.rule, sizeof(slots[i].header.rule), "%s", lifeOptions.rule);
+        slots[i].cells = memAlloc(cellBytes);
+    }
+    stopping = 0;
+    pthread_create(&writer, NULL, writerMain, NULL);
+}
+
+void checkpointCapture(const Engine *engine, void *field, long long generation, unsigned char *row) {
+    int slot, x, y;
+    int width = slots[0].header.width;
+
+    /* Take back a snapshot the writer has not started on, else the slot it is not using. */
+    pthread_mutex_lock(&lock);
+    slot = pending >= 0 ? pending : (writing == 0 ? 1 : 0);
+    pending = -1;
+    pthread_mutex_unlock(&lock);
+
+    Snapshot *s = &slots[slot];
+    s->header.generation = generation;
+    for (y = 0; y < s->header.height; y++) {
+        unsigned char *packed = s->cells + rowBytes(width) * y;
+        engine->readRow(field, y, row);
+        for (x = 0; x + 4 <= width; x += 4) {
+            packed[x >> 2] = (unsigned char)(row[x] | row[x + 1] << 2 | row[x + 2] << 4 | row[x + 3] << 6);
+        }
+        if (x < width) {
+            unsigned char last = 0;
+            for (; x < width; x++) {
+                last |= (unsigned char)(row[x] << ((x & 3) * 2));
+            }
+            packed[width >> 2] = last;
+        }
+    }
+
+    pthread_mutex_lock(&lock);
+    pending = slot;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+}
+
+void checkpointStop(void) {
+    int i;
+    if (!checkpointPath) {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    stopping = 1;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+    pthread_join(writer, NULL);
+    for (i = 0; i < 2; i++) {
+        memFree(slots[i].cells, cellBytes);
+    }
+    free(tempPath);
+    checkpointPath = NULL;
+}
@@ -0,0 +1,38 @@
+#ifndef __checkpoint__
+#define __checkpoint__
+
+#include <stdint.h>
+#include "life.h"
+
+/*
+ * Checkpoint file: this header, then the field at 2 bits per cell,
+ * (width + 3) / 4 bytes per row. Fields are stored in host byte order.
+ * Any engine can resume a checkpoint written by any other.
+ */
+typedef struct {
+    char magic[8];
+    int32_t width;
+    int32_t height;
+    int64_t generation;
+    /* State of the random generator: it is counter-based, so the seed the field was drawn from. */
+    int64_t seed;
+    char rule[32];
+} CheckpointHeader;
+
+/* Reads and checks the header only, so the field size can be set before anything is created. */
+int checkpointReadHeader(const char *path, CheckpointHeader *header);
+
+/* Fills a field of the header's size from the checkpoint and returns its generation. */
+int checkpointRestore(const char *path, const Engine *engine, void *field, unsigned char *row, long long *generation);
+
+/*
+ * Writing runs on a thread of its own. checkpointCapture() packs the field into a
+ * free snapshot buffer and hands it over; the stepping thread never waits for the disk.
+ * A snapshot still waiting to be written when the next one comes is replaced.
+ * The file is written next to path and renamed over it when complete.
+ */
+void checkpointStart(const char *path, int width, int height);
+void checkpointCapture(const Engine *engine, void *field, long long generation, unsigned char *row);
+/* Waits until the last captured snapshot is on disk. */
+void checkpointStop(void);
+#endif
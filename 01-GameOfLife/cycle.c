@@ -0,0 +1,22 @@
+#include "cycle.h"
+
+int cycleObserve(CycleDetector *c, uint64_t hash) {
+    int p;
+    if (c->period && c->hashes[(c->count - c->period) % CYCLE_HISTORY] == hash) {
+        c->matched++;
+    } else {
+        /* The shortest period that fits is the period: a field that repeats after p steps repeats after 2p too. */
+        c->period = 0;
+        c->matched = 0;
+        for (p = 1; p <= CYCLE_HISTORY && p <= c->count; p++) {
+            if (c->hashes[(c->count - p) % CYCLE_HISTORY] == hash) {
+                c->period = p;
+                c->matched = 1;
+                break;
+            }
+        }
+    }
+    c->hashes[c->count % CYCLE_HISTORY] = hash;
+    c->count++;
+    return c->matched >= c->period ? c->period : 0;
+}
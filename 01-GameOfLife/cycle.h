@@ -0,0 +1,22 @@
+#ifndef __cycle__
+#define __cycle__
+
+#include <stdint.h>
+#include "sim.h"
+
+/*
+ * Finds the period of a field that has started repeating itself from a ring of the
+ * field hashes of the last CYCLE_HISTORY steps. A period counts as found once every
+ * step of one whole repetition matched the step a period earlier, so a single
+ * hash collision cannot end a run.
+ */
+typedef struct {
+    uint64_t hashes[CYCLE_HISTORY];
+    long long count;
+    int period;
+    int matched;
+} CycleDetector;
+
+/* Takes the hash of the field after the next step. Returns the period in steps once it is confirmed, 0 until then. */
+int cycleObserve(CycleDetector *c, uint64_t hash);
+#endif
@@ -0,0 +1,429 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "life.h"
+#include "mem.h"
+#include "pool.h"
+
+/*
+ * Bit-packed engine. ALIVE1 and ALIVE2 cells are kept in two separate bitplanes,
+ * 64 cells per word, bit x%64 of word x/64 is cell x of a row.
+ * A generation is computed a whole word at a time with full adders:
+ * the total neighbor count comes from the union of both planes and
+ * the majority color of a birth from the ALIVE1 plane alone.
+ * The rule is applied as a sum of count equalities; for the hot rules the masks are
+ * compile-time constants and only the terms of their counts remain.
+ *
+ * Rows are stepped in cache blocks. Their size comes from --block, or with auto from timing
+ * every candidate on a sample of the field when it is created; cost does not depend on the cells.
+ */
+typedef struct {
+    int width;
+    int height;
+    int words;
+    uint64_t lastMask;
+    uint64_t *plane1;
+    uint64_t *plane2;
+    uint64_t *next1;
+    uint64_t *next2;
+    BandFn band;
+    int blockWords;
+    int blockRows;
+    /* Hash of every row, kept from the first bitplaneHash() call on. */
+    uint64_t *rowHash;
+} BitplaneField;
+
+static BandFn bandForRule(void);
+static void chooseBlocks(BitplaneField *f);
+
+/* The word helpers must be inlined into every rule instance for the masks to fold. */
+#define INLINE static inline __attribute__((always_inline))
+
+static void *bitplaneCreate(int width, int height) {
+    BitplaneField *f = memAlloc(sizeof(BitplaneField));
+    size_t size;
+    f->width = width;
+    f->height = height;
+    f->words = (width + 63) / 64;
+    f->lastMask = (width % 64) ? (((uint64_t)1 << (width % 64)) - 1) : ~(uint64_t)0;
+    size = (size_t)f->words * height;
+    f->plane1 = memAlloc(size * sizeof(uint64_t));
+    f->plane2 = memAlloc(size * sizeof(uint64_t));
+    f->next1 = memAlloc(size * sizeof(uint64_t));
+    f->next2 = memAlloc(size * sizeof(uint64_t));
+    f->band = bandForRule();
+    f->rowHash = NULL;
+    chooseBlocks(f);
+    return f;
+}
+
+static void bitplaneDestroy(void *field) {
+    BitplaneField *f = field;
+    size_t size = (size_t)f->words * f->height * sizeof(uint64_t);
+    memFree(f->plane1, size);
+    memFree(f->plane2, size);
+    memFree(f->next1, size);
+    memFree(f->next2, size);
+    memFree(f->rowHash, sizeof(uint64_t) * f->height);
+    memFree(f, sizeof(BitplaneField));
+}
+
+/* Cells at x-1 moved to position x, the row wraps around at width. */
+INLINE uint64_t westOf(const uint64_t *row, int i, int words, int width) {
+    uint64_t carry = i > 0 ? row[i - 1] >> 63 : (row[words - 1] >> ((width - 1) & 63)) & 1;
+    return (row[i] << 1) | carry;
+}
+
+/* Cells at x+1 moved to position x. */
+INLINE uint64_t eastOf(const uint64_t *row, int i, int words, int width) {
+    uint64_t carry = i < words - 1 ? row[i + 1] << 63 : (row[0] & 1) << ((width - 1) & 63);
+    return (row[i] >> 1) | carry;
+}
+
+INLINE void fullAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t *sum, uint64_t *carry) {
+    uint64_t u = a ^ b;
+    *sum = u ^ c;
+    *carry = (a & b) | (u & c);
+}
+
+/* Adds eight one-bit numbers per bit position, result in b[0..3]. */
+INLINE void count8(const uint64_t n[8], uint64_t b[4]) {
+    uint64_t s1, c1, s2, c2, s3, c3, c4, t, c5;
+    fullAdd(n[0], n[1], n[2], &s1, &c1);
+    fullAdd(n[3], n[4], n[5], &s2, &c2);
+    s3 = n[6] ^ n[7];
+    c3 = n[6] & n[7];
+    fullAdd(s1, s2, s3, &b[0], &c4);
+    fullAdd(c1, c2, c3, &t, &c5);
+    b[1] = t ^ c4;
+    b[2] = c5 ^ (t & c4);
+    b[3] = c5 & t & c4;
+}
+
+/* Bit positions where the count c (0..8) is n. Bit 3 only tells 0 from 8 apart. */
+INLINE uint64_t countIs(const uint64_t c[4], int n) {
+    uint64_t is = (n & 1 ? c[0] : ~c[0]) & (n & 2 ? c[1] : ~c[1]) & (n & 4 ? c[2] : ~c[2]);
+    if (n == 0) {
+        is &= ~c[3];
+    } else if (n == 8) {
+        is &= c[3];
+    }
+    return is;
+}
+
+/*
+ * Bit positions where the count c is at least n, compared from the top bit down.
+ * Only bits that a count of at most max can have are looked at.
+ */
+INLINE uint64_t countAtLeast(const uint64_t c[4], int n, int max) {
+    uint64_t greater = 0;
+    uint64_t equal = ~(uint64_t)0;
+    int i;
+    for (i = 3; i >= 0; i--) {
+        if ((1 << i) > max) {
+            continue;
+        }
+        if (n & (1 << i)) {
+            equal &= c[i];
+        } else {
+            greater |= equal & c[i];
+            equal &= ~c[i];
+        }
+        if (!(n & ((1 << i) - 1))) {
+            break;
+        }
+    }
+    return greater | equal;
+}
+
+INLINE void gather(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                          int i, int words, int width, uint64_t n[8]) {
+    n[0] = westOf(up, i, words, width);
+    n[1] = up[i];
+    n[2] = eastOf(up, i, words, width);
+    n[3] = westOf(mid, i, words, width);
+    n[4] = eastOf(mid, i, words, width);
+    n[5] = westOf(down, i, words, width);
+    n[6] = down[i];
+    n[7] = eastOf(down, i, words, width);
+}
+
+/* ALIVE1 wins a birth iff it holds more than half of the n parents. */
+#define RULE_TERM(n) \
+    do { \
+        if (survive & (1 << (n))) { \
+            keep |= countIs(total, n); \
+        } \
+        if (birth & (1 << (n))) { \
+            uint64_t is = countIs(total, n); \
+            born |= is; \
+            born1 |= is & countAtLeast(ones, (n) / 2 + 1, n); \
+        } \
+    } while (0)
+
+static uint64_t hashRow(const uint64_t *p1, const uint64_t *p2, int words, int y) {
+    uint64_t h = (uint64_t)y;
+    int i;
+    for (i = 0; i < words; i++) {
+        h = (h ^ p1[i]) * 0x9E3779B97F4A7C15ull;
+        h = (h ^ p2[i]) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 32;
+    }
+    return lifeMix(h);
+}
+
+/* Words i0..i1-1 of rows y0..y1-1. */
+INLINE void bitplaneBlock(BitplaneField *f, int y0, int y1, int i0, int i1,
+                          int birth, int survive) {
+    int words = f->words;
+    int width = f->width;
+    int height = f->height;
+    int y, i, k;
+
+    for (y = y0; y < y1; y++) {
+        size_t up = (size_t)((y + height - 1) % height) * words;
+        size_t mid = (size_t)y * words;
+        size_t down = (size_t)((y + 1) % height) * words;
+
+        for (i = i0; i < i1; i++) {
+            uint64_t n1[8], n2[8], all[8];
+            uint64_t total[4], ones[4];
+
+            gather(f->plane1 + up, f->plane1 + mid, f->plane1 + down, i, words, width, n1);
+            gather(f->plane2 + up, f->plane2 + mid, f->plane2 + down, i, words, width, n2);
+            for (k = 0; k < 8; k++) {
+                all[k] = n1[k] | n2[k];
+            }
+            count8(all, total);
+            count8(n1, ones);
+
+            uint64_t self1 = f->plane1[mid + i];
+            uint64_t self2 = f->plane2[mid + i];
+            uint64_t alive = self1 | self2;
+            uint64_t keep = 0;
+            uint64_t born = 0;
+            uint64_t born1 = 0;
+            /* Unrolled by hand so constant masks leave only the terms of their counts. */
+            RULE_TERM(0); RULE_TERM(1); RULE_TERM(2); RULE_TERM(3); RULE_TERM(4);
+            RULE_TERM(5); RULE_TERM(6); RULE_TERM(7); RULE_TERM(8);
+            keep &= alive;
+            born &= ~alive;
+            born1 &= ~alive;
+            uint64_t mask = i == words - 1 ? f->lastMask : ~(uint64_t)0;
+
+            f->next1[mid + i] = ((self1 & keep) | born1) & mask;
+            f->next2[mid + i] = ((self2 & keep) | (born & ~born1)) & mask;
+        }
+    }
+}
+
+/*
+ * Rows y0..y1-1, one block of blockRows x blockWords at a time: the three input rows of a block stay in
+ * cache from one output row to the next, where whole rows of a wide field would have been evicted.
+ * Every word is computed exactly as without blocks, only the order differs.
+ */
+INLINE void bitplaneRows(BitplaneField *f, int y0, int y1,
+                         int birth, int survive) {
+    int by, i, y;
+
+    for (by = y0; by < y1; by += f->blockRows) {
+        int by1 = y1 - by > f->blockRows ? by + f->blockRows : y1;
+        for (i = 0; i < f->words; i += f->blockWords) {
+            int i1 = f->words - i > f->blockWords ? i + f->blockWords : f->words;
+            bitplaneBlock(f, by, by1, i, i1, birth, survive);
+        }
+        if (f->rowHash) {
+            for (y = by; y < by1; y++) {
+                size_t row = (size_t)y * f->words;
+                f->rowHash[y] = hashRow(f->next1 + row, f->next2 + row, f->words, y);
+            }
+        }
+    }
+}
+
+#define RULE_BAND(name, text, b, s) \
+    static void bitplaneBand##name(void *field, int y0, int y1) { \
+        bitplaneRows(field, y0, y1, b, s); \
+    }
+LIFE_HOT_RULES(RULE_BAND)
+
+static void bitplaneBandAny(void *field, int y0, int y1) {
+    bitplaneRows(field, y0, y1, lifeRule.birth, lifeRule.survive);
+}
+
+static BandFn bandForRule(void) {
+#define PICK_BAND(name, text, b, s) \
+    if (lifeRule.birth == (b) && lifeRule.survive == (s)) return bitplaneBand##name;
+    LIFE_HOT_RULES(PICK_BAND)
+    return bitplaneBandAny;
+}
+
+/* CPU time of the calling thread, so time slices given to other processes do not count. */
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Best of five steps of rows 0..rows-1 into next, which leaves the field as it is. */
+static double timeBlocks(BitplaneField *f, int rows, int blockWords, int blockRows) {
+    double best = 1e30;
+    int r;
+    f->blockWords = blockWords;
+    f->blockRows = blockRows;
+    for (r = 0; r < 5; r++) {
+        double start = seconds();
+        f->band(f, 0, rows);
+        double elapsed = seconds() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+/* Block sizes calibration tries, 0 for whole rows or whole bands. */
+static const int blockWordsTried[] = {0, 4, 8, 16, 32, 64, 128, 256};
+static const int blockRowsTried[] = {0, 8, 32};
+
+#define CALIBRATION_CELLS (1 << 22)
+
+static void chooseBlocks(BitplaneField *f) {
+    int width, height;
+    size_t a, b;
+    if (strcmp(lifeOptions.block, "auto") != 0) {
+        if (sscanf(lifeOptions.block, "%dx%d", &width, &height) != 2) {
+            width = f->width;
+            height = f->height;
+        }
+        f->blockWords = (width + 63) / 64 < f->words ? (width + 63) / 64 : f->words;
+        f->blockRows = height;
+        return;
+    }
+
+    int rows = CALIBRATION_CELLS / f->width > 64 ? CALIBRATION_CELLS / f->width : 64;
+    rows = rows < f->height ? rows : f->height;
+    double whole = timeBlocks(f, rows, f->words, f->height);
+    double best = whole;
+    int bestWords = f->words;
+    int bestRows = f->height;
+    for (a = 0; a < sizeof(blockWordsTried) / sizeof(blockWordsTried[0]); a++) {
+        int words = blockWordsTried[a] ? blockWordsTried[a] : f->words;
+        if (words > f->words) {
+            continue;
+        }
+        for (b = 0; b < sizeof(blockRowsTried) / sizeof(blockRowsTried[0]); b++) {
+            int blockRows = blockRowsTried[b] ? blockRowsTried[b] : f->height;
+            if (blockRows > rows || (words == f->words && blockRows == f->height)) {
+                continue;
+            }
+            double t = timeBlocks(f, rows, words, blockRows);
+            /* Blocks have to win clearly, whole rows are the simpler access pattern. */
+            if (t < best * 0.95) {
+                best = t;
+                bestWords = words;
+                bestRows = blockRows;
+            }
+        }
+    }
+    f->blockWords = bestWords;
+    f->blockRows = bestRows;
+
+    double cells = (double)rows * f->width;
+    if (bestWords == f->words && bestRows == f->height) {
+        printf("bitplane: whole rows, %.3f ns/cell\n", whole * 1e9 / cells);
+    } else {
+        printf("bitplane: %dx%d cell blocks, %.3f ns/cell against %.3f with whole rows\n",
+               bestWords * 64, bestRows, best * 1e9 / cells, whole * 1e9 / cells);
+    }
+}
+
+static void bitplaneStats(void *field, char *buf, int size) {
+    BitplaneField *f = field;
+    if (f->blockWords == f->words && f->blockRows >= f->height) {
+        snprintf(buf, size, "whole rows");
+    } else {
+        snprintf(buf, size, "blocks %dx%d", f->blockWords * 64, f->blockRows);
+    }
+}
+
+static void bitplaneStep(void *field) {
+    BitplaneField *f = field;
+
+    poolRun(f->band, f, f->height);
+
+    uint64_t *tmp = f->plane1;
+    f->plane1 = f->next1;
+    f->next1 = tmp;
+    tmp = f->plane2;
+    f->plane2 = f->next2;
+    f->next2 = tmp;
+}
+
+/* Rows are converted a word at a time, without branches, so loading and saving whole fields stays cheap. */
+static void bitplaneReadRow(void *field, int y, unsigned char *row) {
+    BitplaneField *f = field;
+    const uint64_t *p1 = f->plane1 + (size_t)y * f->words;
+    const uint64_t *p2 = f->plane2 + (size_t)y * f->words;
+    int i, b;
+    for (i = 0; i < f->words; i++) {
+        int n = i == f->words - 1 ? f->width - i * 64 : 64;
+        unsigned char *cells = row + i * 64;
+        for (b = 0; b < n; b++) {
+            cells[b] = (unsigned char)(((p1[i] >> b) & 1) | (((p2[i] >> b) & 1) << 1));
+        }
+    }
+}
+
+static void bitplaneWriteRow(void *field, int y, const unsigned char *row) {
+    BitplaneField *f = field;
+    uint64_t *p1 = f->plane1 + (size_t)y * f->words;
+    uint64_t *p2 = f->plane2 + (size_t)y * f->words;
+    int i, b;
+    for (i = 0; i < f->words; i++) {
+        int n = i == f->words - 1 ? f->width - i * 64 : 64;
+        const unsigned char *cells = row + i * 64;
+        uint64_t w1 = 0;
+        uint64_t w2 = 0;
+        for (b = 0; b < n; b++) {
+            w1 |= (uint64_t)(cells[b] == ALIVE1) << b;
+            w2 |= (uint64_t)(cells[b] == ALIVE2) << b;
+        }
+        p1[i] = w1;
+        p2[i] = w2;
+    }
+    if (f->rowHash) {
+        f->rowHash[y] = hashRow(p1, p2, f->words, y);
+    }
+}
+
+static uint64_t bitplaneHash(void *field) {
+    BitplaneField *f = field;
+    uint64_t h = 0;
+    int y;
+    if (!f->rowHash) {
+        f->rowHash = memAlloc(sizeof(uint64_t) * f->height);
+        for (y = 0; y < f->height; y++) {
+            size_t row = (size_t)y * f->words;
+            f->rowHash[y] = hashRow(f->plane1 + row, f->plane2 + row, f->words, y);
+        }
+    }
+    for (y = 0; y < f->height; y++) {
+        h ^= f->rowHash[y];
+    }
+    return h;
+}
+
+const Engine bitplaneEngine = {
+    "bitplane",
+    bitplaneCreate,
+    bitplaneDestroy,
+    bitplaneStep,
+    bitplaneReadRow,
+    bitplaneWriteRow,
+    NULL,
+    bitplaneStats,
+    bitplaneHash,
+};
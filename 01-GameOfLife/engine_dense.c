@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include "life.h"
+#include "mem.h"
+
+/*
+ * Reference engine: one int per cell, neighbors are looked up with modulo wraparound.
+ */
+typedef struct {
+    int width;
+    int height;
+    int *current;
+    int *next;
+} DenseField;
+
+static void *denseCreate(int width, int height) {
+    DenseField *f = memAlloc(sizeof(DenseField));
+    f->width = width;
+    f->height = height;
+    f->current = memAlloc((size_t)width * height * sizeof(int));
+    f->next = memAlloc((size_t)width * height * sizeof(int));
+    return f;
+}
+
+static void denseDestroy(void *field) {
+    DenseField *f = field;
+    memFree(f->current, (size_t)f->width * f->height * sizeof(int));
+    memFree(f->next, (size_t)f->width * f->height * sizeof(int));
+    memFree(f, sizeof(DenseField));
+}
+
+static void denseStep(void *field) {
+    DenseField *f = field;
+    int width = f->width;
+    int height = f->height;
+    int *current = f->current;
+    int *next = f->next;
+    int birth = lifeRule.birth;
+    int survive = lifeRule.survive;
+    int y, x;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            int neighbors = 0;
+            int count1 = 0;
+            int count2 = 0;
+            int dy, dx;
+            for (dy = -1; dy <= 1; dy++) {
+                for (dx = -1; dx <= 1; dx++) {
+                    if (dy == 0 && dx == 0) continue;
+                    int ny = (y + dy + height) % height;
+                    int nx = (x + dx + width) % width;
+                    if (current[(size_t)ny * width + nx] == ALIVE1) {
+                        neighbors++;
+                        count1++;
+                    } else if (current[(size_t)ny * width + nx] == ALIVE2) {
+                        neighbors++;
+                        count2++;
+                    }
+                }
+            }
+            if (current[(size_t)y * width + x] > DEAD) {
+                if (survive & (1 << neighbors)) {
+                    next[(size_t)y * width + x] = current[(size_t)y * width + x];
+                } else {
+                    next[(size_t)y * width + x] = DEAD;
+                }
+            } else {
+                if (birth & (1 << neighbors)) {
+                    if (count1 > count2) {
+                        next[(size_t)y * width + x] = ALIVE1;
+                    } else {
+                        next[(size_t)y * width + x] = ALIVE2;
+                    }
+                } else {
+                    next[(size_t)y * width + x] = DEAD;
+                }
+            }
+        }
+    }
+
+    f->current = next;
+    f->next = current;
+}
+
+static void denseReadRow(void *field, int y, unsigned char *row) {
+    DenseField *f = field;
+    int x;
+    for (x = 0; x < f->width; x++) {
+        row[x] = (unsigned char)f->current[(size_t)y * f->width + x];
+    }
+}
+
+static void denseWriteRow(void *field, int y, const unsigned char *row) {
+    DenseField *f = field;
+    int x;
+    for (x = 0; x < f->width; x++) {
+        f->current[(size_t)y * f->width + x] = row[x];
+    }
+}
+
+const Engine denseEngine = {
+    "dense",
+    denseCreate,
+    denseDestroy,
+    denseStep,
+    denseReadRow,
+    denseWriteRow,
+    NULL,
+    NULL,
+    NULL,
+};
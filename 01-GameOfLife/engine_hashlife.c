@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "life.h"
+#include "mem.h"
+
+/*
+ * HashLife engine. The field is a quadtree of hash-consed nodes: every distinct
+ * 2^k x 2^k block exists once, and each node memoizes its RESULT - the centered
+ * 2^(k-1) block advanced 2^(k-2) generations (or fewer, see successor()).
+ * Node ids 0..2 are the single cells DEAD, ALIVE1, ALIVE2.
+ *
+ * The torus is a level-n node T. Its 2x2 tiling is the torus unfolded, so the
+ * RESULT of node(T, T, T, T) is the exact torus advanced 2^(n-1) generations,
+ * shifted by half a field. Width and height must be powers of two (lifeParseArgs() checks); a rectangular
+ * field is tiled into the square root node.
+ *
+ * Nodes live in one growable array with a free list. When more than the
+ * configured memory is in use, a mark-and-sweep collection between steps keeps
+ * only the current field and drops memoized results that pointed elsewhere.
+ *
+ * Between two collections no node is freed, so a node id names one field for good:
+ * the root id together with the number of collections is an exact hash of the field.
+ */
+#define NONE 0xFFFFFFFFu
+#define MAX_LEVEL 32
+
+typedef struct {
+    uint32_t child[4]; /* nw, ne, sw, se */
+    uint32_t result;
+    uint32_t next;
+    uint8_t level;
+    uint8_t empty;
+    uint8_t mark;
+} Node;
+
+typedef struct {
+    int width;
+    int height;
+    int level;
+    uint32_t root;
+
+    Node *nodes;
+    uint32_t used;
+    uint32_t capacity;
+    uint32_t freeList;
+    uint32_t live;
+    uint32_t maxNodes;
+
+    uint32_t *buckets;
+    uint32_t bucketMask;
+
+    uint32_t empty[MAX_LEVEL + 1];
+    int memoLog;
+    uint32_t collections;
+} HashlifeField;
+
+static uint32_t hashChildren(const uint32_t c[4]) {
+    uint64_t h = c[0];
+    h = h * 0x9E3779B97F4A7C15ull + c[1];
+    h = h * 0x9E3779B97F4A7C15ull + c[2];
+    h = h * 0x9E3779B97F4A7C15ull + c[3];
+    return (uint32_t)(h ^ (h >> 29));
+}
+
+static void rehash(HashlifeField *f, uint32_t buckets) {
+    uint32_t i;
+    if (f->buckets) {
+        memFree(f->buckets, sizeof(uint32_t) * ((size_t)f->bucketMask + 1));
+    }
+    f->buckets = memAlloc(sizeof(uint32_t) * (size_t)buckets);
+    f->bucketMask = buckets - 1;
+    for (i = 0; i < buckets; i++) {
+        f->buckets[i] = NONE;
+    }
+    for (i = 3; i < f->used; i++) {
+        Node *n = &f->nodes[i];
+        if (n->level != 0xFF) {
+            uint32_t b = hashChildren(n->child) & f->bucketMask;
+            n->next = f->buckets[b];
+            f->buckets[b] = i;
+        }
+    }
+}
+
+/* Canonical node with the given children, created if it does not exist yet. */
+static uint32_t findNode(HashlifeField *f, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t c[4] = {nw, ne, sw, se};
+    uint32_t b = hashChildren(c) & f->bucketMask;
+    uint32_t i;
+    Node *n;
+
+    for (i = f->buckets[b]; i != NONE; i = f->nodes[i].next) {
+        n = &f->nodes[i];
+        if (n->child[0] == nw && n->child[1] == ne && n->child[2] == sw && n->child[3] == se) {
+            return i;
+        }
+    }
+
+    if (f->freeList != NONE) {
+        i = f->freeList;
+        f->freeList = f->nodes[i].next;
+    } else {
+        if (f->used == f->capacity) {
+            Node *nodes = memAlloc(sizeof(Node) * (size_t)f->capacity * 2);
+            memcpy(nodes, f->nodes, sizeof(Node) * (size_t)f->capacity);
+            memFree(f->nodes, sizeof(Node) * (size_t)f->capacity);
+            f->nodes = nodes;
+            f->capacity *= 2;
+        }
+        i = f->used++;
+    }
+
+    n = &f->nodes[i];
+    memcpy(n->child, c, sizeof(c));
+    n->result = NONE;
+    n->level = f->nodes[nw].level + 1;
+    n->empty = f->nodes[nw].empty && f->nodes[ne].empty && f->nodes[sw].empty && f->nodes[se].empty;
+    n->mark = 0;
+    n->next = f->buckets[b];
+    f->buckets[b] = i;
+
+    if (++f->live > f->bucketMask + 1) {
+        rehash(f, (f->bucketMask + 1) * 2);
+    }
+    return i;
+}
+
+static inline uint32_t child(const HashlifeField *f, uint32_t n, int q) {
+    return f->nodes[n].child[q];
+}
+
+/* Level-2 base case: the center 2x2 of a 4x4 block after one generation. */
+static uint32_t leafResult(HashlifeField *f, uint32_t n) {
+    unsigned char g[4][4];
+    unsigned char r[4];
+    int y, x, q;
+
+    for (q = 0; q < 4; q++) {
+        uint32_t sub = child(f, n, q);
+        for (y = 0; y < 2; y++) {
+            for (x = 0; x < 2; x++) {
+                g[(q >> 1) * 2 + y][(q & 1) * 2 + x] = (unsigned char)child(f, sub, y * 2 + x);
+            }
+        }
+    }
+
+    for (q = 0; q < 4; q++) {
+        int cy = 1 + (q >> 1);
+        int cx = 1 + (q & 1);
+        int count1 = 0;
+        int count2 = 0;
+        for (y = cy - 1; y <= cy + 1; y++) {
+            for (x = cx - 1; x <= cx + 1; x++) {
+                if (y == cy && x == cx) continue;
+                count1 += g[y][x] == ALIVE1;
+                count2 += g[y][x] == ALIVE2;
+            }
+        }
+        r[q] = lifeTransitions[LIFE_INDEX(g[cy][cx], count1, count2)];
+    }
+    return findNode(f, r[0], r[1], r[2], r[3]);
+}
+
+/* Level k-1 node at the center of a level k node, no time advance. */
+static uint32_t centered(HashlifeField *f, uint32_t n) {
+    return findNode(f, child(f, child(f, n, 0), 3), child(f, child(f, n, 1), 2),
+                    child(f, child(f, n, 2), 1), child(f, child(f, n, 3), 0));
+}
+
+/*
+ * Center 2^(k-1) block of level k node n advanced 2^j generations, j <= k-2.
+ * For a fixed top-level step every level always runs with the same j,
+ * so a single memo slot per node is enough.
+ */
+static uint32_t successor(HashlifeField *f, uint32_t n, int j) {
+    int k = f->nodes[n].level;
+    uint32_t sub[9], quad[4], res[4];
+    uint32_t nw, ne, sw, se;
+    int i;
+
+    if (f->nodes[n].result != NONE) {
+        return f->nodes[n].result;
+    }
+    if (f->nodes[n].empty) {
+        f->nodes[n].result = f->empty[k - 1];
+        return f->empty[k - 1];
+    }
+    if (k == 2) {
+        uint32_t r = leafResult(f, n);
+        f->nodes[n].result = r;
+        return r;
+    }
+
+    nw = child(f, n, 0);
+    ne = child(f, n, 1);
+    sw = child(f, n, 2);
+    se = child(f, n, 3);
+
+    /* Nine overlapping level k-1 blocks */
+    sub[0] = nw;
+    sub[1] = findNode(f, child(f, nw, 1), child(f, ne, 0), child(f, nw, 3), child(f, ne, 2));
+    sub[2] = ne;
+    sub[3] = findNode(f, child(f, nw, 2), child(f, nw, 3), child(f, sw, 0), child(f, sw, 1));
+    sub[4] = findNode(f, child(f, nw, 3), child(f, ne, 2), child(f, sw, 1), child(f, se, 0));
+    sub[5] = findNode(f, child(f, ne, 2), child(f, ne, 3), child(f, se, 0), child(f, se, 1));
+    sub[6] = sw;
+    sub[7] = findNode(f, child(f, sw, 1), child(f, se, 0), child(f, sw, 3), child(f, se, 2));
+    sub[8] = se;
+
+    for (i = 0; i < 9; i++) {
+        sub[i] = j == k - 2 ? successor(f, sub[i], k - 3) : centered(f, sub[i]);
+    }
+
+    quad[0] = findNode(f, sub[0], sub[1], sub[3], sub[4]);
+    quad[1] = findNode(f, sub[1], sub[2], sub[4], sub[5]);
+    quad[2] = findNode(f, sub[3], sub[4], sub[6], sub[7]);
+    quad[3] = findNode(f, sub[4], sub[5], sub[7], sub[8]);
+    for (i = 0; i < 4; i++) {
+        res[i] = successor(f, quad[i], j == k - 2 ? k - 3 : j);
+    }
+
+    uint32_t r = findNode(f, res[0], res[1], res[2], res[3]);
+    f->nodes[n].result = r;
+    return r;
+}
+
+static void clearResults(HashlifeField *f) {
+    uint32_t i;
+    for (i = 0; i < f->used; i++) {
+        f->nodes[i].result = NONE;
+    }
+}
+
+static void markNode(HashlifeField *f, uint32_t n) {
+    int q;
+    if (f->nodes[n].mark) {
+        return;
+    }
+    f->nodes[n].mark = 1;
+    if (f->nodes[n].level > 0) {
+        for (q = 0; q < 4; q++) {
+            markNode(f, child(f, n, q));
+        }
+    }
+}
+
+static void collect(HashlifeField *f) {
+    uint32_t i;
+    int k;
+
+    f->collections++;
+    markNode(f, f->root);
+    for (k = 0; k <= f->level + 1; k++) {
+        markNode(f, f->empty[k]);
+    }
+
+    f->freeList = NONE;
+    f->live = 3;
+    for (i = 3; i < f->used; i++) {
+        Node *n = &f->nodes[i];
+        if (n->level == 0xFF) {
+            n->next = f->freeList;
+            f->freeList = i;
+        } else if (!n->mark) {
+            n->level = 0xFF;
+            n->next = f->freeList;
+            f->freeList = i;
+        } else {
+            f->live++;
+        }
+    }
+    for (i = 0; i < f->used; i++) {
+        Node *n = &f->nodes[i];
+        if (n->level != 0xFF && n->result != NONE && !f->nodes[n->result].mark) {
+            n->result = NONE;
+        }
+    }
+    for (i = 0; i < f->used; i++) {
+        f->nodes[i].mark = 0;
+    }
+    rehash(f, f->bucketMask + 1);
+}
+
+static uint32_t setCell(HashlifeField *f, uint32_t n, int level, int x, int y, unsigned char v) {
+    uint32_t c[4];
+    int half, q;
+
+    if (level == 0) {
+        return v;
+    }
+    half = 1 << (level - 1);
+    q = (y >= half) * 2 + (x >= half);
+    memcpy(c, f->nodes[n].child, sizeof(c));
+    c[q] = setCell(f, c[q], level - 1, x & (half - 1), y & (half - 1), v);
+    return findNode(f, c[0], c[1], c[2], c[3]);
+}
+
+static void readRowOf(const HashlifeField *f, uint32_t n, int level, int x0, int y, unsigned char *row) {
+    int half, north;
+
+    if (x0 >= f->width) {
+        return;
+    }
+    if (level == 0) {
+        row[x0] = (unsigned char)n;
+        return;
+    }
+    half = 1 << (level - 1);
+    if (f->nodes[n].empty) {
+        memset(row + x0, DEAD, (size_t)((x0 + 2 * half <= f->width) ? 2 * half : f->width - x0));
+        return;
+    }
+    north = y < half;
+    readRowOf(f, child(f, n, north ? 0 : 2), level - 1, x0, y & (half - 1), row);
+    readRowOf(f, child(f, n, north ? 1 : 3), level - 1, x0 + half, y & (half - 1), row);
+}
+
+static int log2Exact(int v) {
+    int k = 0;
+    while ((1 << k) < v) {
+        k++;
+    }
+    return (1 << k) == v ? k : -1;
+}
+
+static void *hashlifeCreate(int width, int height) {
+    lifeInitTransitions();
+    HashlifeField *f = memAlloc(sizeof(HashlifeField));
+    int a = log2Exact(width);
+    int b = log2Exact(height);
+    int k;
+
+    f->width = width;
+    f->height = height;
+    f->level = a > b ? a : b;
+    if (f->level < 1) {
+        f->level = 1;
+    }
+
+    f->capacity = 1 << 16;
+    f->nodes = memAlloc(sizeof(Node) * (size_t)f->capacity);
+    f->used = 3;
+    f->live = 3;
+    f->freeList = NONE;
+    f->maxNodes = (uint32_t)(((uint64_t)lifeOptions.hashlifeMemory << 20) / (sizeof(Node) + sizeof(uint32_t)));
+    f->memoLog = -1;
+    for (k = 0; k < 3; k++) {
+        memset(&f->nodes[k], 0, sizeof(Node));
+        f->nodes[k].result = NONE;
+        f->nodes[k].empty = k == DEAD;
+    }
+    rehash(f, 1 << 16);
+
+    f->empty[0] = DEAD;
+    for (k = 1; k <= f->level + 1 && k <= MAX_LEVEL; k++) {
+        f->empty[k] = findNode(f, f->empty[k - 1], f->empty[k - 1], f->empty[k - 1], f->empty[k - 1]);
+    }
+    f->root = f->empty[f->level];
+    return f;
+}
+
+static void hashlifeDestroy(void *field) {
+    HashlifeField *f = field;
+    memFree(f->nodes, sizeof(Node) * (size_t)f->capacity);
+    memFree(f->buckets, sizeof(uint32_t) * ((size_t)f->bucketMask + 1));
+    memFree(f, sizeof(HashlifeField));
+}
+
+static void hashlifeJump(void *field, int stepLog) {
+    HashlifeField *f = field;
+    int j = stepLog < f->level - 1 ? stepLog : f->level - 1;
+    long long repeats = 1LL << (stepLog - j);
+    long long r;
+
+    if (f->live > f->maxNodes) {
+        collect(f);
+    }
+    if (f->memoLog != j) {
+        clearResults(f);
+        f->memoLog = j;
+    }
+
+    for (r = 0; r < repeats; r++) {
+        uint32_t tiled = findNode(f, f->root, f->root, f->root, f->root);
+        uint32_t shifted = successor(f, tiled, j);
+        f->root = findNode(f, child(f, shifted, 3), child(f, shifted, 2),
+                           child(f, shifted, 1), child(f, shifted, 0));
+    }
+}
+
+static void hashlifeStep(void *field) {
+    hashlifeJump(field, 0);
+}
+
+static void hashlifeReadRow(void *field, int y, unsigned char *row) {
+    HashlifeField *f = field;
+    readRowOf(f, f->root, f->level, 0, y, row);
+}
+
+static void hashlifeWriteRow(void *field, int y, const unsigned char *row) {
+    HashlifeField *f = field;
+    unsigned char *old = memAlloc(f->width);
+    int size = 1 << f->level;
+    int x, tx, ty;
+
+    readRowOf(f, f->root, f->level, 0, y, old);
+    for (x = 0; x < f->width; x++) {
+        if (old[x] == row[x]) continue;
+        for (ty = y; ty < size; ty += f->height) {
+            for (tx = x; tx < size; tx += f->width) {
+                f->root = setCell(f, f->root, f->level, tx, ty, row[x]);
+            }
+        }
+    }
+    memFree(old, f->width);
+}
+
+static void hashlifeStats(void *field, char *buf, int size) {
+    HashlifeField *f = field;
+    snprintf(buf, size, "nodes %u/%u", f->live, f->maxNodes);
+}
+
+static uint64_t hashlifeHash(void *field) {
+    HashlifeField *f = field;
+    return lifeMix((uint64_t)f->collections << 32 | f->root);
+}
+
+const Engine hashlifeEngine = {
+    "hashlife",
+    hashlifeCreate,
+    hashlifeDestroy,
+    hashlifeStep,
+    hashlifeReadRow,
+    hashlifeWriteRow,
+    hashlifeJump,
+    hashlifeStats,
+    hashlifeHash,
+};
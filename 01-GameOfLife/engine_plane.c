@@ -0,0 +1,516 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "life.h"
+#include "mem.h"
+#include "pool.h"
+
+/*
+ * Unbounded plane engine. Instead of a torus the field is an infinite plane of which
+ * app() sees the width x height window at the origin; cells outside of it keep evolving,
+ * so spaceships leave instead of wrapping around.
+ *
+ * The plane is cut into CHUNK x CHUNK chunks, and only chunks holding live cells, or
+ * bordering live cells of a neighbor, exist. They are kept in an open-addressing hash map
+ * keyed by chunk coordinates, and come from a slab pool: a chunk that stayed empty for a
+ * generation and is not needed as a border is returned to its slab, a slab with no chunk
+ * in use is released. Memory follows the population, not the area.
+ *
+ * A chunk is stepped from a halo copy of itself and its 8 neighbors, with the lifeTransitions
+ * table indexed by the byte sum of the neighbors in the vector engine's 0x01/0x10 encoding.
+ * Like the vector engine's tiles, a chunk that did not change in the last generation, next to
+ * neighbors that did not either, is not recomputed. Chunks are stepped in parallel on the pool.
+ */
+#define CHUNK_LOG 6
+#define CHUNK (1 << CHUNK_LOG)
+#define HALO (CHUNK + 2)
+#define SLAB_CHUNKS 16
+#define MIN_BUCKETS 64
+
+/* Edges holding live cells, a bit per neighbor that may see births. */
+enum { EDGE_N = 1, EDGE_S = 2, EDGE_W = 4, EDGE_E = 8, EDGE_NW = 16, EDGE_NE = 32, EDGE_SW = 64, EDGE_SE = 128 };
+
+/* Neighbor offsets in around[] order, the same as the EDGE_* bits, and the neighbor's edge facing back. */
+static const int aroundX[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+static const int aroundY[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+static const int opposite[8] = {1, 0, 3, 2, 7, 6, 5, 4};
+
+typedef struct Slab Slab;
+
+typedef struct Chunk {
+    int cx;
+    int cy;
+    int index;
+    int population;
+    unsigned char cur;
+    unsigned char changed;
+    unsigned char stepped;
+    unsigned char edges;
+    unsigned char hashed;
+    uint64_t hash;
+    struct Chunk *around[8];
+    struct Chunk *nextFree;
+    Slab *slab;
+    unsigned char cells[2][CHUNK * CHUNK];
+} Chunk;
+
+struct Slab {
+    Slab *prev;
+    Slab *next;
+    Chunk *free;
+    int used;
+    Chunk chunks[SLAB_CHUNKS];
+};
+
+typedef struct {
+    int width;
+    int height;
+
+    Chunk **buckets;
+    uint32_t bucketMask;
+
+    Chunk **chunks;
+    int count;
+    int capacity;
+
+    /* Slabs with at least one free chunk, and how many slabs exist. */
+    Slab *partial;
+    int slabs;
+
+    int steppedCount;
+    long long population;
+} PlaneField;
+
+static const unsigned char encode[3] = {0x00, 0x01, 0x10};
+
+static uint32_t bucketOf(const PlaneField *f, int cx, int cy) {
+    return (uint32_t)lifeMix((uint64_t)(uint32_t)cx << 32 | (uint32_t)cy) & f->bucketMask;
+}
+
+static void rehash(PlaneField *f, uint32_t buckets) {
+    Chunk **old = f->buckets;
+    uint32_t oldCount = old ? f->bucketMask + 1 : 0;
+    uint32_t i;
+    f->buckets = memAlloc(sizeof(Chunk *) * (size_t)buckets);
+    f->bucketMask = buckets - 1;
+    for (i = 0; i < oldCount; i++) {
+        if (old[i]) {
+            uint32_t b = bucketOf(f, old[i]->cx, old[i]->cy);
+            while (f->buckets[b]) {
+                b = (b + 1) & f->bucketMask;
+            }
+            f->buckets[b] = old[i];
+        }
+    }
+    if (old) {
+        memFree(old, sizeof(Chunk *) * (size_t)oldCount);
+    }
+}
+
+static Chunk *findChunk(const PlaneField *f, int cx, int cy) {
+    uint32_t b = bucketOf(f, cx, cy);
+    Chunk *c;
+    while ((c = f->buckets[b]) != NULL) {
+        if (c->cx == cx && c->cy == cy) {
+            return c;
+        }
+        b = (b + 1) & f->bucketMask;
+    }
+    return NULL;
+}
+
+/* Linear probing deletion: entries after the hole move back unless they sit at or after their own bucket. */
+static void unlinkChunk(PlaneField *f, const Chunk *chunk) {
+    uint32_t hole = bucketOf(f, chunk->cx, chunk->cy);
+    uint32_t b;
+    while (f->buckets[hole] != chunk) {
+        hole = (hole + 1) & f->bucketMask;
+    }
+    for (b = (hole + 1) & f->bucketMask; f->buckets[b]; b = (b + 1) & f->bucketMask) {
+        uint32_t home = bucketOf(f, f->buckets[b]->cx, f->buckets[b]->cy);
+        if (((b - home) & f->bucketMask) >= ((b - hole) & f->bucketMask)) {
+            f->buckets[hole] = f->buckets[b];
+            hole = b;
+        }
+    }
+    f->buckets[hole] = NULL;
+}
+
+static void linkSlab(PlaneField *f, Slab *slab) {
+    slab->prev = NULL;
+    slab->next = f->partial;
+    if (f->partial) {
+        f->partial->prev = slab;
+    }
+    f->partial = slab;
+}
+
+static void unlinkSlab(PlaneField *f, Slab *slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        f->partial = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+static Chunk *allocChunk(PlaneField *f) {
+    Slab *slab = f->partial;
+    Chunk *c;
+    int i;
+    if (!slab) {
+        slab = memAlloc(sizeof(Slab));
+        for (i = SLAB_CHUNKS - 1; i >= 0; i--) {
+            slab->chunks[i].slab = slab;
+            slab->chunks[i].nextFree = slab->free;
+            slab->free = &slab->chunks[i];
+        }
+        linkSlab(f, slab);
+        f->slabs++;
+    }
+    c = slab->free;
+    slab->free = c->nextFree;
+    if (++slab->used == SLAB_CHUNKS) {
+        unlinkSlab(f, slab);
+    }
+    return c;
+}
+
+/* Returns the chunk to its slab. A slab left without chunks in use is released unless it is the only spare. */
+static void releaseChunk(PlaneField *f, Chunk *c) {
+    Slab *slab = c->slab;
+    if (slab->used-- == SLAB_CHUNKS) {
+        linkSlab(f, slab);
+    }
+    c->nextFree = slab->free;
+    slab->free = c;
+    if (slab->used == 0 && (slab->prev || slab->next)) {
+        unlinkSlab(f, slab);
+        memFree(slab, sizeof(Slab));
+        f->slabs--;
+    }
+}
+
+/* Adds an all-DEAD chunk. An absent chunk was DEAD in the last generation as well, so it starts unchanged. */
+static Chunk *addChunk(PlaneField *f, int cx, int cy) {
+    Chunk *c = allocChunk(f);
+    uint32_t b;
+    c->cx = cx;
+    c->cy = cy;
+    c->population = 0;
+    c->cur = 0;
+    c->changed = 0;
+    c->edges = 0;
+    c->hashed = 0;
+    memset(c->cells[0], DEAD, sizeof(c->cells[0]));
+
+    if (f->count == f->capacity) {
+        Chunk **chunks = memAlloc(sizeof(Chunk *) * (size_t)(f->capacity ? f->capacity * 2 : 64));
+        if (f->chunks) {
+            memcpy(chunks, f->chunks, sizeof(Chunk *) * (size_t)f->count);
+            memFree(f->chunks, sizeof(Chunk *) * (size_t)f->capacity);
+        }
+        f->chunks = chunks;
+        f->capacity = f->capacity ? f->capacity * 2 : 64;
+    }
+    c->index = f->count;
+    f->chunks[f->count++] = c;
+
+    if ((uint32_t)f->count * 2 > f->bucketMask + 1) {
+        rehash(f, (f->bucketMask + 1) * 2);
+    }
+    b = bucketOf(f, cx, cy);
+    while (f->buckets[b]) {
+        b = (b + 1) & f->bucketMask;
+    }
+    f->buckets[b] = c;
+    return c;
+}
+
+static void removeChunk(PlaneField *f, Chunk *c) {
+    unlinkChunk(f, c);
+    f->chunks[c->index] = f->chunks[--f->count];
+    f->chunks[c->index]->index = c->index;
+    releaseChunk(f, c);
+    if ((uint32_t)f->count * 8 < f->bucketMask + 1 && f->bucketMask + 1 > MIN_BUCKETS) {
+        rehash(f, (f->bucketMask + 1) / 2);
+    }
+}
+
+static int floorDiv(int v) {
+    return v >= 0 ? v >> CHUNK_LOG : -((-v + CHUNK - 1) >> CHUNK_LOG);
+}
+
+/* Live cells of a chunk on each of its edges, as EDGE_* bits. */
+static int edgesOf(const unsigned char *cells) {
+    int edges = 0;
+    int i;
+    for (i = 0; i < CHUNK; i++) {
+        if (cells[i]) edges |= EDGE_N;
+        if (cells[(CHUNK - 1) * CHUNK + i]) edges |= EDGE_S;
+        if (cells[i * CHUNK]) edges |= EDGE_W;
+        if (cells[i * CHUNK + CHUNK - 1]) edges |= EDGE_E;
+    }
+    if (cells[0]) edges |= EDGE_NW;
+    if (cells[CHUNK - 1]) edges |= EDGE_NE;
+    if (cells[(CHUNK - 1) * CHUNK]) edges |= EDGE_SW;
+    if (cells[CHUNK * CHUNK - 1]) edges |= EDGE_SE;
+    return edges;
+}
+
+static void *planeCreate(int width, int height) {
+    PlaneField *f = memAlloc(sizeof(PlaneField));
+    f->width = width;
+    f->height = height;
+    rehash(f, MIN_BUCKETS);
+    lifeInitTransitions();
+    return f;
+}
+
+static void planeDestroy(void *field) {
+    PlaneField *f = field;
+    while (f->count) {
+        removeChunk(f, f->chunks[f->count - 1]);
+    }
+    while (f->partial) {
+        Slab *slab = f->partial;
+        unlinkSlab(f, slab);
+        memFree(slab, sizeof(Slab));
+    }
+    memFree(f->buckets, sizeof(Chunk *) * ((size_t)f->bucketMask + 1));
+    memFree(f->chunks, sizeof(Chunk *) * (size_t)f->capacity);
+    memFree(f, sizeof(PlaneField));
+}
+
+/* Copies the cells around chunk c in the encoding of the neighbor sums, DEAD where there is no neighbor. */
+static void fillHalo(const Chunk *c, unsigned char *halo) {
+    static const int corner[4][3] = {
+        /* around index, source cell, halo cell */
+        {4, CHUNK * CHUNK - 1, 0},
+        {5, (CHUNK - 1) * CHUNK, HALO - 1},
+        {6, CHUNK - 1, (HALO - 1) * HALO},
+        {7, 0, HALO * HALO - 1},
+    };
+    const unsigned char *self = c->cells[c->cur];
+    const Chunk *n;
+    int x, y, i;
+    for (y = 0; y < CHUNK; y++) {
+        unsigned char *dst = halo + (size_t)(y + 1) * HALO + 1;
+        const unsigned char *src = self + y * CHUNK;
+        for (x = 0; x < CHUNK; x++) {
+            dst[x] = encode[src[x]];
+        }
+    }
+    n = c->around[0];
+    for (x = 0; x < CHUNK; x++) {
+        halo[1 + x] = n ? encode[n->cells[n->cur][(CHUNK - 1) * CHUNK + x]] : 0;
+    }
+    n = c->around[1];
+    for (x = 0; x < CHUNK; x++) {
+        halo[(HALO - 1) * HALO + 1 + x] = n ? encode[n->cells[n->cur][x]] : 0;
+    }
+    n = c->around[2];
+    for (y = 0; y < CHUNK; y++) {
+        halo[(y + 1) * HALO] = n ? encode[n->cells[n->cur][y * CHUNK + CHUNK - 1]] : 0;
+    }
+    n = c->around[3];
+    for (y = 0; y < CHUNK; y++) {
+        halo[(y + 1) * HALO + HALO - 1] = n ? encode[n->cells[n->cur][y * CHUNK]] : 0;
+    }
+    for (i = 0; i < 4; i++) {
+        n = c->around[corner[i][0]];
+        halo[corner[i][2]] = n ? encode[n->cells[n->cur][corner[i][1]]] : 0;
+    }
+}
+
+/* Steps one chunk into its other buffer; the swap happens once every chunk has read its neighbors. */
+static void stepChunk(Chunk *c) {
+    unsigned char halo[HALO * HALO];
+    unsigned char column[HALO];
+    const unsigned char *in = c->cells[c->cur];
+    unsigned char *out = c->cells[c->cur ^ 1];
+    int population = 0;
+    int changed = 0;
+    int x, y;
+    fillHalo(c, halo);
+    for (y = 1; y <= CHUNK; y++) {
+        const unsigned char *up = halo + (size_t)(y - 1) * HALO;
+        const unsigned char *mid = up + HALO;
+        const unsigned char *down = mid + HALO;
+        for (x = 0; x < HALO; x++) {
+            column[x] = (unsigned char)(up[x] + mid[x] + down[x]);
+        }
+        for (x = 1; x <= CHUNK; x++) {
+            int self = in[(y - 1) * CHUNK + x - 1];
+            int sum = column[x - 1] + column[x] + column[x + 1] - mid[x];
+            unsigned char next = lifeTransitions[self << 8 | sum];
+            out[(y - 1) * CHUNK + x - 1] = next;
+            population += next != DEAD;
+            changed |= next != self;
+        }
+    }
+    c->population = population;
+    c->changed = (unsigned char)changed;
+    c->edges = (unsigned char)edgesOf(out);
+}
+
+static void planeBand(void *ctx, int i0, int i1) {
+    PlaneField *f = ctx;
+    int i;
+    for (i = i0; i < i1; i++) {
+        Chunk *c = f->chunks[i];
+        if (c->stepped) {
+            stepChunk(c);
+        }
+    }
+}
+
+static void planeStep(void *field) {
+    PlaneField *f = field;
+    int i, k;
+
+    /* Every live edge needs the chunk across it to exist, so births there are computed. */
+    for (i = 0; i < f->count; i++) {
+        Chunk *c = f->chunks[i];
+        for (k = 0; k < 8; k++) {
+            if ((c->edges & (1 << k)) && !findChunk(f, c->cx + aroundX[k], c->cy + aroundY[k])) {
+                addChunk(f, c->cx + aroundX[k], c->cy + aroundY[k]);
+            }
+        }
+    }
+    /*
+     * A chunk that has been empty for a generation and borders no live edge would stay empty, so it goes.
+     * The chunk moved into its slot of the list is looked at next.
+     */
+    for (i = 0; i < f->count;) {
+        Chunk *c = f->chunks[i];
+        int needed = c->population || c->changed;
+        for (k = 0; k < 8 && !needed; k++) {
+            Chunk *n = findChunk(f, c->cx + aroundX[k], c->cy + aroundY[k]);
+            needed = n && (n->edges & (1 << opposite[k]));
+        }
+        if (needed) {
+            i++;
+        } else {
+            removeChunk(f, c);
+        }
+    }
+    f->steppedCount = 0;
+    for (i = 0; i < f->count; i++) {
+        Chunk *c = f->chunks[i];
+        int active = c->changed;
+        for (k = 0; k < 8; k++) {
+            c->around[k] = findChunk(f, c->cx + aroundX[k], c->cy + aroundY[k]);
+            active |= c->around[k] && c->around[k]->changed;
+        }
+        c->stepped = (unsigned char)active;
+        f->steppedCount += active;
+    }
+
+    poolRun(planeBand, f, f->count);
+
+    f->population = 0;
+    for (i = 0; i < f->count; i++) {
+        Chunk *c = f->chunks[i];
+        if (c->stepped) {
+            c->cur ^= 1;
+            c->hashed &= !c->changed;
+        } else {
+            c->changed = 0;
+        }
+        f->population += c->population;
+    }
+}
+
+static void planeReadRow(void *field, int y, unsigned char *row) {
+    PlaneField *f = field;
+    int cy = floorDiv(y);
+    int x = 0;
+    while (x < f->width) {
+        int cx = floorDiv(x);
+        int end = (cx + 1) * CHUNK < f->width ? (cx + 1) * CHUNK : f->width;
+        const Chunk *c = findChunk(f, cx, cy);
+        if (c) {
+            memcpy(row + x, c->cells[c->cur] + (y - cy * CHUNK) * CHUNK + (x - cx * CHUNK), (size_t)(end - x));
+        } else {
+            memset(row + x, DEAD, (size_t)(end - x));
+        }
+        x = end;
+    }
+}
+
+static void planeWriteRow(void *field, int y, const unsigned char *row) {
+    PlaneField *f = field;
+    int cy = floorDiv(y);
+    int x = 0;
+    while (x < f->width) {
+        int cx = floorDiv(x);
+        int end = (cx + 1) * CHUNK < f->width ? (cx + 1) * CHUNK : f->width;
+        Chunk *c = findChunk(f, cx, cy);
+        int i;
+        if (!c) {
+            for (i = x; i < end && row[i] == DEAD; i++) {
+            }
+            if (i < end) {
+                c = addChunk(f, cx, cy);
+            }
+        }
+        if (c) {
+            unsigned char *cells = c->cells[c->cur] + (y - cy * CHUNK) * CHUNK + (x - cx * CHUNK);
+            for (i = 0; i < end - x; i++) {
+                c->population += (row[x + i] != DEAD) - (cells[i] != DEAD);
+                c->changed |= row[x + i] != cells[i];
+                cells[i] = row[x + i];
+            }
+            c->edges = (unsigned char)edgesOf(c->cells[c->cur]);
+            c->hashed &= !c->changed;
+        }
+        x = end;
+    }
+}
+
+/* Sum of the hashes of the non-empty chunks, so it does not depend on which empty chunks exist or their order. */
+static uint64_t planeHash(void *field) {
+    PlaneField *f = field;
+    uint64_t h = 0;
+    int i, j;
+    for (i = 0; i < f->count; i++) {
+        Chunk *c = f->chunks[i];
+        if (!c->population) {
+            continue;
+        }
+        if (!c->hashed) {
+            const unsigned char *cells = c->cells[c->cur];
+            uint64_t ch = 0xCBF29CE484222325ull ^ ((uint64_t)(uint32_t)c->cx << 32 | (uint32_t)c->cy);
+            for (j = 0; j < CHUNK * CHUNK; j++) {
+                ch = (ch ^ cells[j]) * 0x100000001B3ull;
+            }
+            c->hash = lifeMix(ch);
+            c->hashed = 1;
+        }
+        h += c->hash;
+    }
+    return h;
+}
+
+static void planeStats(void *field, char *buf, int size) {
+    PlaneField *f = field;
+    snprintf(buf, size, "%d chunks (%d stepped), %lld live cells, %d slabs, %.1f KiB", f->count, f->steppedCount,
+             f->population, f->slabs,
+             (f->slabs * sizeof(Slab) + (f->bucketMask + 1) * sizeof(Chunk *) + f->capacity * sizeof(Chunk *)) / 1024.0);
+}
+
+const Engine planeEngine = {
+    "plane",
+    planeCreate,
+    planeDestroy,
+    planeStep,
+    planeReadRow,
+    planeWriteRow,
+    NULL,
+    planeStats,
+    planeHash,
+};
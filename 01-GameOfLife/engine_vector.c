@@ -0,0 +1,565 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "grid.h"
+#include "mem.h"
+#include "pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#else
+#define HAVE_X86 0
+#endif
+
+/*
+ * Byte-per-cell engine with SSE2/AVX2 row kernels.
+ * A neighbor is encoded as 0x01 for ALIVE1 and 0x10 for ALIVE2, so a single byte sum
+ * of eight neighbors holds count1 in the low nibble and count2 in the high one.
+ * The row kernel is picked once at startup from cpuid, or forced with --kernel.
+ * The field lives in a HaloGrid, so kernels never wrap around and have no per-cell branches.
+ *
+ * The grid is also split into square tiles. A tile is recomputed only if it or one of
+ * its eight neighbors changed in the previous generation. A tile that did not change
+ * holds the same cells in both buffers, so skipping it needs no copy.
+ *
+ * With --temporal k, jump() advances the field k generations per pass over it instead of one.
+ * Each TEMPORAL_TILE square is copied with a skirt of k cells into a scratch buffer that stays
+ * in cache, stepped k times there on a region shrinking by one cell per generation, and only its
+ * exact center is written back. The skirt is computed redundantly, the field is read and written
+ * once per k generations. Activity tiles are not tracked across such passes.
+ */
+typedef void (*RowKernel)(const unsigned char *up, const unsigned char *mid, const unsigned char *down,
+                          unsigned char *out, int x0, int x1);
+
+typedef struct {
+    HaloGrid current;
+    HaloGrid next;
+    int tileSize;
+    int tilesX;
+    int tilesY;
+    unsigned char *changed;
+    unsigned char *active;
+    int activeTiles;
+    /* Hash of every tile from the first vectorHash() call on, only changed tiles are rehashed. */
+    uint64_t *tileHash;
+    int hashStale;
+    /* Generations of the last temporal pass, 0 if the last step was a plain one. */
+    int passSteps;
+    /* Two temporal tiles with their skirt per pool thread, NULL without --temporal. */
+    unsigned char *scratch;
+    size_t scratchSize;
+} VectorField;
+
+#define TEMPORAL_TILE 256
+
+static RowKernel rowKernel = NULL;
+static const char *rowKernelName = NULL;
+
+#define ENC(c) (((c) & 1) | (((c) & 2) << 3))
+
+/*
+ * Kernels take the rule masks as arguments and are always inlined: the hot-rule instances
+ * below pass constants, so the masks fold away, the Any instances read lifeRule once per row.
+ */
+#define INLINE static inline __attribute__((always_inline))
+
+INLINE void rowScalarRule(const unsigned char *up, const unsigned char *mid, const unsigned char *down,
+                          unsigned char *out, int x0, int x1, int birth, int survive) {
+    int x;
+    for (x = x0; x < x1; x++) {
+        int s = ENC(up[x - 1]) + ENC(up[x]) + ENC(up[x + 1]) +
+                ENC(mid[x - 1]) + ENC(mid[x + 1]) +
+                ENC(down[x - 1]) + ENC(down[x]) + ENC(down[x + 1]);
+        out[x] = lifeNextCell(mid[x], s & 15, s >> 4, birth, survive);
+    }
+}
+
+/* The byte sum already is the low part of a LIFE_INDEX, so the next state is a single table load. */
+static void rowLut(const unsigned char *up, const unsigned char *mid, const unsigned char *down,
+                   unsigned char *out, int x0, int x1) {
+    int x;
+    for (x = x0; x < x1; x++) {
+        int s = ENC(up[x - 1]) + ENC(up[x]) + ENC(up[x + 1]) +
+                ENC(mid[x - 1]) + ENC(mid[x + 1]) +
+                ENC(down[x - 1]) + ENC(down[x]) + ENC(down[x + 1]);
+        out[x] = lifeTransitions[mid[x] << 8 | s];
+    }
+}
+
+/* The rule written as a branch tree, kept as the baseline the other kernels are measured against. */
+static void rowBranch(const unsigned char *up, const unsigned char *mid, const unsigned char *down,
+                      unsigned char *out, int x0, int x1) {
+    int x, i;
+    for (x = x0; x < x1; x++) {
+        const unsigned char around[8] = {up[x - 1], up[x], up[x + 1], mid[x - 1],
+                                         mid[x + 1], down[x - 1], down[x], down[x + 1]};
+        int neighbors = 0;
+        int count1 = 0;
+        for (i = 0; i < 8; i++) {
+            if (around[i] == ALIVE1) {
+                neighbors++;
+                count1++;
+            } else if (around[i] == ALIVE2) {
+                neighbors++;
+            }
+        }
+        if (mid[x] > DEAD) {
+            if (lifeRule.survive & (1 << neighbors)) {
+                out[x] = mid[x];
+            } else {
+                out[x] = DEAD;
+            }
+        } else if (lifeRule.birth & (1 << neighbors)) {
+            if (count1 > neighbors - count1) {
+                out[x] = ALIVE1;
+            } else {
+                out[x] = ALIVE2;
+            }
+        } else {
+            out[x] = DEAD;
+        }
+    }
+}
+
+#if HAVE_X86
+__attribute__((target("sse2")))
+static inline __m128i enc128(const unsigned char *p) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    return _mm_or_si128(_mm_and_si128(v, _mm_set1_epi8(1)),
+                        _mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi8(2)), 3));
+}
+
+/* 0xFF in the bytes whose count has its bit set in mask, one compare per count in the mask. */
+#define MATCH128(n) \
+    if (mask & (1 << (n))) r = _mm_or_si128(r, _mm_cmpeq_epi8(total, _mm_set1_epi8(n)))
+
+__attribute__((target("sse2")))
+INLINE __m128i countIn128(__m128i total, int mask) {
+    __m128i r = _mm_setzero_si128();
+    MATCH128(0); MATCH128(1); MATCH128(2); MATCH128(3); MATCH128(4);
+    MATCH128(5); MATCH128(6); MATCH128(7); MATCH128(8);
+    return r;
+}
+
+__attribute__((target("sse2")))
+INLINE void rowSse2Rule(const unsigned char *up, const unsigned char *mid, const unsigned char *down,
+                        unsigned char *out, int x0, int x1, int birth, int survive) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi8(2);
+    const __m128i low = _mm_set1_epi8(15);
+    int x = x0;
+
+    for (; x + 16 <= x1; x += 16) {
+        __m128i s = _mm_add_epi8(_mm_add_epi8(enc128(up + x - 1), enc128(up + x)),
+                                 _mm_add_epi8(enc128(up + x + 1), enc128(mid + x - 1)));
+        s = _mm_add_epi8(s, _mm_add_epi8(_mm_add_epi8(enc128(mid + x + 1), enc128(down + x - 1)),
+                                         _mm_add_epi8(enc128(down + x), enc128(down + x + 1))));
+        __m128i self = _mm_loadu_si128((const __m128i *)(mid + x));
+        __m128i count1 = _mm_and_si128(s, low);
+        __m128i count2 = _mm_and_si128(_mm_srli_epi16(s, 4), low);
+        __m128i total = _mm_add_epi8(count1, count2);
+        __m128i dead = _mm_cmpeq_epi8(self, zero);
+        /* two + (-1) gives ALIVE1 where count1 > count2 */
+        __m128i color = _mm_add_epi8(two, _mm_cmpgt_epi8(count1, count2));
+        __m128i survived = _mm_andnot_si128(dead, _mm_and_si128(countIn128(total, survive), self));
+        __m128i born = _mm_and_si128(_mm_and_si128(dead, countIn128(total, birth)), color);
+        _mm_storeu_si128((__m128i *)(out + x), _mm_or_si128(survived, born));
+    }
+    rowScalarRule(up, mid, down, out, x, x1, birth, survive);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i enc256(const unsigned char *p) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    return _mm256_or_si256(_mm256_and_si256(v, _mm256_set1_epi8(1)),
+                           _mm256_slli_epi16(_mm256_and_si256(v, _mm256_set1_epi8(2)), 3));
+}
+
+/* Byte n is 0xFF if bit n of the birth/survive mask is set, looked up with one shuffle per vector. */
+static _Alignas(16) unsigned char birthBytes[16];
+static _Alignas(16) unsigned char surviveBytes[16];
+
+/* AVX2 has a byte shuffle, so the rule is a table lookup and needs no per-rule instances. */
+__attribute__((target("avx2")))
+static void rowAvx2(const unsigned char *up, const unsigned char *mid, const unsigned char *down,
+                    unsigned char *out, int x0, int x1) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi8(2);
+    const __m256i low = _mm256_set1_epi8(15);
+    const __m256i birth = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)birthBytes));
+    const __m256i survive = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)surviveBytes));
+    int x = x0;
+
+    for (; x + 32 <= x1; x += 32) {
+        __m256i s = _mm256_add_epi8(_mm256_add_epi8(enc256(up + x - 1), enc256(up + x)),
+                                    _mm256_add_epi8(enc256(up + x + 1), enc256(mid + x - 1)));
+        s = _mm256_add_epi8(s, _mm256_add_epi8(_mm256_add_epi8(enc256(mid + x + 1), enc256(down + x - 1)),
+                                               _mm256_add_epi8(enc256(down + x), enc256(down + x + 1))));
+        __m256i self = _mm256_loadu_si256((const __m256i *)(mid + x));
+        __m256i count1 = _mm256_and_si256(s, low);
+        __m256i count2 = _mm256_and_si256(_mm256_srli_epi16(s, 4), low);
+        __m256i total = _mm256_add_epi8(count1, count2);
+        __m256i dead = _mm256_cmpeq_epi8(self, zero);
+        __m256i color = _mm256_add_epi8(two, _mm256_cmpgt_epi8(count1, count2));
+        __m256i survived = _mm256_andnot_si256(dead, _mm256_and_si256(_mm256_shuffle_epi8(survive, total), self));
+        __m256i born = _mm256_and_si256(_mm256_and_si256(dead, _mm256_shuffle_epi8(birth, total)), color);
+        _mm256_storeu_si256((__m256i *)(out + x), _mm256_or_si256(survived, born));
+    }
+    rowScalarRule(up, mid, down, out, x, x1, lifeRule.birth, lifeRule.survive);
+}
+#endif
+
+#define SCALAR_KERNEL(name, text, b, s) \
+    static void rowScalar##name(const unsigned char *up, const unsigned char *mid, const unsigned char *down, \
+                                unsigned char *out, int x0, int x1) { \
+        rowScalarRule(up, mid, down, out, x0, x1, b, s); \
+    }
+LIFE_HOT_RULES(SCALAR_KERNEL)
+SCALAR_KERNEL(Any, "", lifeRule.birth, lifeRule.survive)
+
+#if HAVE_X86
+#define SSE2_KERNEL(name, text, b, s) \
+    __attribute__((target("sse2"))) \
+    static void rowSse2##name(const unsigned char *up, const unsigned char *mid, const unsigned char *down, \
+                              unsigned char *out, int x0, int x1) { \
+        rowSse2Rule(up, mid, down, out, x0, x1, b, s); \
+    }
+LIFE_HOT_RULES(SSE2_KERNEL)
+SSE2_KERNEL(Any, "", lifeRule.birth, lifeRule.survive)
+#endif
+
+static void selectKernel(const char *name) {
+    int any = strcmp(name, "auto") == 0;
+    RowKernel scalar = rowScalarAny;
+#if HAVE_X86
+    RowKernel sse2 = rowSse2Any;
+#define PICK_KERNELS(name, text, b, s) \
+    if (lifeRule.birth == (b) && lifeRule.survive == (s)) { scalar = rowScalar##name; sse2 = rowSse2##name; }
+#else
+#define PICK_KERNELS(name, text, b, s) \
+    if (lifeRule.birth == (b) && lifeRule.survive == (s)) scalar = rowScalar##name;
+#endif
+    LIFE_HOT_RULES(PICK_KERNELS)
+
+    rowKernel = scalar;
+    rowKernelName = "scalar";
+    lifeInitTransitions();
+    if (strcmp(name, "lut") == 0) {
+        rowKernel = rowLut;
+        rowKernelName = "lut";
+        return;
+    }
+    if (strcmp(name, "branch") == 0) {
+        rowKernel = rowBranch;
+        rowKernelName = "branch";
+        return;
+    }
+#if HAVE_X86
+    int n;
+    for (n = 0; n < 16; n++) {
+        birthBytes[n] = n <= 8 && (lifeRule.birth & (1 << n)) ? 0xFF : 0;
+        surviveBytes[n] = n <= 8 && (lifeRule.survive & (1 << n)) ? 0xFF : 0;
+    }
+    __builtin_cpu_init();
+    if ((any || strcmp(name, "avx2") == 0) && __builtin_cpu_supports("avx2")) {
+        rowKernel = rowAvx2;
+        rowKernelName = "avx2";
+    } else if ((any || strcmp(name, "sse2") == 0) && __builtin_cpu_supports("sse2")) {
+        rowKernel = sse2;
+        rowKernelName = "sse2";
+    }
+#else
+    (void)any;
+#endif
+}
+
+const char *vectorKernelName(void) {
+    if (!rowKernel) {
+        selectKernel(lifeOptions.kernel);
+    }
+    return rowKernelName;
+}
+
+static void *vectorCreate(int width, int height) {
+    VectorField *f = memAlloc(sizeof(VectorField));
+    haloInit(&f->current, width, height);
+    haloInit(&f->next, width, height);
+    f->tileSize = lifeOptions.tileSize;
+    f->tilesX = (width + f->tileSize - 1) / f->tileSize;
+    f->tilesY = (height + f->tileSize - 1) / f->tileSize;
+    f->changed = memAlloc((size_t)f->tilesX * f->tilesY);
+    f->active = memAlloc((size_t)f->tilesX * f->tilesY);
+    memset(f->changed, 1, (size_t)f->tilesX * f->tilesY);
+    f->activeTiles = f->tilesX * f->tilesY;
+    f->tileHash = NULL;
+    f->hashStale = 1;
+    f->passSteps = 0;
+    f->scratch = NULL;
+    f->scratchSize = 0;
+    if (lifeOptions.temporal >= 2) {
+        size_t side = TEMPORAL_TILE + 2 * lifeOptions.temporal;
+        f->scratchSize = 2 * side * side * poolThreads();
+        f->scratch = memAlloc(f->scratchSize);
+    }
+    vectorKernelName();
+    return f;
+}
+
+static void vectorDestroy(void *field) {
+    VectorField *f = field;
+    haloFree(&f->current);
+    haloFree(&f->next);
+    memFree(f->changed, (size_t)f->tilesX * f->tilesY);
+    memFree(f->active, (size_t)f->tilesX * f->tilesY);
+    memFree(f->tileHash, sizeof(uint64_t) * f->tilesX * f->tilesY);
+    memFree(f->scratch, f->scratchSize);
+    memFree(f, sizeof(VectorField));
+}
+
+static uint64_t hashTile(const HaloGrid *grid, int t, int x0, int x1, int y0, int y1) {
+    uint64_t h = (uint64_t)t;
+    int x, y;
+    for (y = y0; y < y1; y++) {
+        const unsigned char *row = haloRow(grid, y);
+        for (x = x0; x + 8 <= x1; x += 8) {
+            uint64_t w;
+            memcpy(&w, row + x, 8);
+            h = (h ^ w) * 0x9E3779B97F4A7C15ull;
+            h ^= h >> 32;
+        }
+        for (; x < x1; x++) {
+            h = (h ^ row[x]) * 0x100000001B3ull;
+        }
+    }
+    return lifeMix(h);
+}
+
+/* Steps tile rows ty0..ty1-1. */
+static void vectorBand(void *field, int ty0, int ty1) {
+    VectorField *f = field;
+    int width = f->current.width;
+    int height = f->current.height;
+    int ty, tx, y;
+
+    for (ty = ty0; ty < ty1; ty++) {
+        int y0 = ty * f->tileSize;
+        int y1 = y0 + f->tileSize < height ? y0 + f->tileSize : height;
+        for (tx = 0; tx < f->tilesX; tx++) {
+            int t = ty * f->tilesX + tx;
+            int x0 = tx * f->tileSize;
+            int x1 = x0 + f->tileSize < width ? x0 + f->tileSize : width;
+            int changed = 0;
+            if (!f->active[t]) {
+                f->changed[t] = 0;
+                continue;
+            }
+            for (y = y0; y < y1; y++) {
+                const unsigned char *mid = haloRow(&f->current, y);
+                unsigned char *out = haloRow(&f->next, y);
+                rowKernel(haloRow(&f->current, y - 1), mid, haloRow(&f->current, y + 1), out, x0, x1);
+                changed |= memcmp(out + x0, mid + x0, x1 - x0) != 0;
+            }
+            f->changed[t] = (unsigned char)changed;
+            if (changed && f->tileHash) {
+                f->tileHash[t] = hashTile(&f->next, t, x0, x1, y0, y1);
+            }
+        }
+    }
+}
+
+static void markActiveTiles(VectorField *f) {
+    int tx, ty, dx, dy;
+    f->activeTiles = 0;
+    for (ty = 0; ty < f->tilesY; ty++) {
+        for (tx = 0; tx < f->tilesX; tx++) {
+            unsigned char active = 0;
+            for (dy = -1; dy <= 1; dy++) {
+                int ny = (ty + dy + f->tilesY) % f->tilesY;
+                for (dx = -1; dx <= 1; dx++) {
+                    int nx = (tx + dx + f->tilesX) % f->tilesX;
+                    active |= f->changed[ny * f->tilesX + nx];
+                }
+            }
+            f->active[ty * f->tilesX + tx] = active;
+            f->activeTiles += active;
+        }
+    }
+}
+
+static void vectorStep(void *field) {
+    VectorField *f = field;
+
+    haloRefresh(&f->current);
+    markActiveTiles(f);
+    poolRun(vectorBand, f, f->tilesY);
+
+    HaloGrid tmp = f->current;
+    f->current = f->next;
+    f->next = tmp;
+}
+
+/* Cells x..x+n-1 of a torus row, x may lie outside 0..width-1 and n may exceed width. */
+static void copyWrapped(unsigned char *dst, const unsigned char *row, int width, int x, int n) {
+    x = (x % width + width) % width;
+    while (n > 0) {
+        int run = width - x < n ? width - x : n;
+        memcpy(dst, row + x, run);
+        dst += run;
+        n -= run;
+        x = 0;
+    }
+}
+
+/* Advances the temporal tiles of tile rows ty0..ty1-1 by passSteps generations, from current into next. */
+static void temporalBand(void *field, int ty0, int ty1) {
+    VectorField *f = field;
+    int width = f->current.width;
+    int height = f->current.height;
+    int k = f->passSteps;
+    int side = TEMPORAL_TILE + 2 * k;
+    size_t scratchSide = TEMPORAL_TILE + 2 * lifeOptions.temporal;
+    unsigned char *a = f->scratch + 2 * scratchSide * scratchSide * poolIndex();
+    unsigned char *b = a + scratchSide * scratchSide;
+    int tilesX = (width + TEMPORAL_TILE - 1) / TEMPORAL_TILE;
+    int tx, ty, r, g;
+
+    for (ty = ty0; ty < ty1; ty++) {
+        int y0 = ty * TEMPORAL_TILE;
+        int h = height - y0 < TEMPORAL_TILE ? height - y0 : TEMPORAL_TILE;
+        for (tx = 0; tx < tilesX; tx++) {
+            int x0 = tx * TEMPORAL_TILE;
+            int w = width - x0 < TEMPORAL_TILE ? width - x0 : TEMPORAL_TILE;
+            int regionWidth = w + 2 * k;
+            int regionHeight = h + 2 * k;
+            unsigned char *src = a;
+            unsigned char *dst = b;
+
+            for (r = 0; r < regionHeight; r++) {
+                int y = ((y0 - k + r) % height + height) % height;
+                copyWrapped(src + (size_t)r * side, haloRow(&f->current, y), width, x0 - k, regionWidth);
+            }
+            /* After g generations only cells at least g away from the region border are exact. */
+            for (g = 1; g <= k; g++) {
+                for (r = g; r < regionHeight - g; r++) {
+                    const unsigned char *mid = src + (size_t)r * side;
+                    rowKernel(mid - side, mid, mid + side, dst + (size_t)r * side, g, regionWidth - g);
+                }
+                unsigned char *tmp = src;
+                src = dst;
+                dst = tmp;
+            }
+            for (r = 0; r < h; r++) {
+                memcpy(haloRow(&f->next, y0 + r) + x0, src + (size_t)(k + r) * side + k, w);
+            }
+        }
+    }
+}
+
+static void vectorJump(void *field, int stepLog) {
+    VectorField *f = field;
+    long long remaining = 1LL << stepLog;
+    int k = lifeOptions.temporal;
+
+    while (remaining > 0) {
+        if (k < 2 || remaining < 2) {
+            vectorStep(f);
+            f->passSteps = 0;
+            remaining--;
+            continue;
+        }
+        f->passSteps = remaining < k ? (int)remaining : k;
+        poolRun(temporalBand, f, (f->current.height + TEMPORAL_TILE - 1) / TEMPORAL_TILE);
+
+        HaloGrid tmp = f->current;
+        f->current = f->next;
+        f->next = tmp;
+        /* Which tiles changed in the last of the k generations is not known, so all count as changed. */
+        memset(f->changed, 1, (size_t)f->tilesX * f->tilesY);
+        f->activeTiles = f->tilesX * f->tilesY;
+        f->hashStale = 1;
+        remaining -= f->passSteps;
+    }
+}
+
+/*
+ * Field bytes a pass reads and writes per cell and generation, the traffic temporal blocking saves.
+ * Stepping one generation at a time reads and writes every cell of the active tiles once.
+ */
+static void vectorStats(void *field, char *buf, int size) {
+    VectorField *f = field;
+    int width = f->current.width;
+    int height = f->current.height;
+    double cells = (double)width * height;
+    double oneStep = 2.0 * f->activeTiles / (f->tilesX * f->tilesY);
+    int k = f->passSteps;
+    int x0, y0;
+
+    if (!k) {
+        snprintf(buf, size, "active tiles %d/%d, %.2f field bytes/cell/generation",
+                 f->activeTiles, f->tilesX * f->tilesY, oneStep);
+        return;
+    }
+    double moved = 0;
+    for (y0 = 0; y0 < height; y0 += TEMPORAL_TILE) {
+        int h = height - y0 < TEMPORAL_TILE ? height - y0 : TEMPORAL_TILE;
+        for (x0 = 0; x0 < width; x0 += TEMPORAL_TILE) {
+            int w = width - x0 < TEMPORAL_TILE ? width - x0 : TEMPORAL_TILE;
+            moved += (double)(w + 2 * k) * (h + 2 * k) + (double)w * h;
+        }
+    }
+    /* Both figures are modelled from tile sizes; a temporal pass leaves every tile active for the next plain step. */
+    snprintf(buf, size, "temporal %d: modelled %.2f field bytes/cell/generation, one-step %.2f",
+             k, moved / cells / k, oneStep);
+}
+
+static void vectorReadRow(void *field, int y, unsigned char *row) {
+    VectorField *f = field;
+    memcpy(row, haloRow(&f->current, y), f->current.width);
+}
+
+static void vectorWriteRow(void *field, int y, const unsigned char *row) {
+    VectorField *f = field;
+    memcpy(haloRow(&f->current, y), row, f->current.width);
+    memset(f->changed + (size_t)(y / f->tileSize) * f->tilesX, 1, f->tilesX);
+    f->hashStale = 1;
+}
+
+static uint64_t vectorHash(void *field) {
+    VectorField *f = field;
+    int width = f->current.width;
+    int height = f->current.height;
+    int tiles = f->tilesX * f->tilesY;
+    uint64_t h = 0;
+    int t;
+    if (!f->tileHash) {
+        f->tileHash = memAlloc(sizeof(uint64_t) * tiles);
+    }
+    if (f->hashStale) {
+        for (t = 0; t < tiles; t++) {
+            int x0 = t % f->tilesX * f->tileSize;
+            int y0 = t / f->tilesX * f->tileSize;
+            int x1 = x0 + f->tileSize < width ? x0 + f->tileSize : width;
+            int y1 = y0 + f->tileSize < height ? y0 + f->tileSize : height;
+            f->tileHash[t] = hashTile(&f->current, t, x0, x1, y0, y1);
+        }
+        f->hashStale = 0;
+    }
+    for (t = 0; t < tiles; t++) {
+        h ^= f->tileHash[t];
+    }
+    return h;
+}
+
+const Engine vectorEngine = {
+    "vector",
+    vectorCreate,
+    vectorDestroy,
+    vectorStep,
+    vectorReadRow,
+    vectorWriteRow,
+    vectorJump,
+    vectorStats,
+    vectorHash,
+};
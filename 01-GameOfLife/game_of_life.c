@@ -1,143 +1,750 @@
 #include "sim.h"
-
-#define DEAD 0
-#define ALIVE1 1
-#define ALIVE2 2
+#include "life.h"
+#include "checkpoint.h"
+#include "cycle.h"
+#include "history.h"
+#include "mem.h"
+#include "pattern.h"
+#include "pool.h"
+#include "triple.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #define SIM_MOUSE_LEFT 1
 #define SIM_MOUSE_RIGHT 3
 #define SIM_KEY_SPACE 44
+#define SIM_KEY_RIGHT 79
+#define SIM_KEY_LEFT 80
+#define SIM_MOUSE_MASK(button) (1 << ((button) - 1))
 
 
-void app() {
-    int current[FIELD_HEIGHT][FIELD_WIDTH];
-    int next[FIELD_HEIGHT][FIELD_WIDTH];
-    int y, x;
-    int last_flush_time = simGetTicks();
+#define BATCH_SIZE 4096
 
-    for (y = 0; y < FIELD_HEIGHT; y++) {
-        for (x = 0; x < FIELD_WIDTH; x++) {
-            current[y][x] = DEAD;
-        }
+/* Cells waiting to be drawn, one batch per cell state so each is a single simFillRects() call. */
+typedef struct {
+    SimRect rects[3][BATCH_SIZE];
+    int count[3];
+} DrawBatch;
+
+static const int cellColors[3] = {DEAD_COLOR, ALIVE_COLOR1, ALIVE_COLOR2};
+
+static void flushBatch(DrawBatch *batch, int cell) {
+    simFillRects(batch->rects[cell], batch->count[cell], cellColors[cell]);
+    batch->count[cell] = 0;
+}
+
+static void drawCell(DrawBatch *batch, int x, int y, unsigned char cell) {
+    SimRect *rect = &batch->rects[cell][batch->count[cell]++];
+    rect->x = x * CELL_SIZE;
+    rect->y = y * CELL_SIZE;
+    rect->w = CELL_SIZE;
+    rect->h = CELL_SIZE;
+    if (batch->count[cell] == BATCH_SIZE) {
+        flushBatch(batch, cell);
     }
+}
 
-#if RANDOM_INIT
-    for (y = 0; y < FIELD_HEIGHT; y++) {
-        for (x = 0; x < FIELD_WIDTH; x++) {
-            if (simRand() % 100 < ALIVE_PROB) {
-                if (simRand() % 2) {
-                    current[y][x] = ALIVE2;
-                } else {
-                    current[y][x] = ALIVE1;
-                }
+/*
+ * Draws the cells of row y that differ from prev, the same row of the last
+ * presented frame, and updates prev. Rows are compared eight cells at a time.
+ */
+static int drawRow(DrawBatch *batch, int y, const unsigned char *row, unsigned char *prev, int width) {
+    int drawn = 0;
+    int x, i;
+    for (x = 0; x < width; x += 8) {
+        int end = x + 8 < width ? x + 8 : width;
+        if (end - x == 8) {
+            uint64_t now, before;
+            memcpy(&now, row + x, 8);
+            memcpy(&before, prev + x, 8);
+            if (now == before) continue;
+        }
+        for (i = x; i < end; i++) {
+            if (row[i] != prev[i]) {
+                drawCell(batch, i, y, row[i]);
+                prev[i] = row[i];
+                drawn++;
             }
         }
     }
-#endif
+    return drawn;
+}
 
-#if EDITOR_MODE
-    int editing = 1;
-    while (editing && !checkFinish()) {
-        for (y = 0; y < FIELD_HEIGHT; y++) {
-            for (x = 0; x < FIELD_WIDTH; x++) {
-                int color;
-                if (current[y][x] == ALIVE1) {
-                    color = ALIVE_COLOR1;
-                } else if (current[y][x] == ALIVE2) {
-                    color = ALIVE_COLOR2;
-                } else {
-                    color = DEAD_COLOR;
-                }
-                simFillRect(x * CELL_SIZE, y * CELL_SIZE, CELL_SIZE, CELL_SIZE, color);
-            }
+static void flushBatches(DrawBatch *batch) {
+    int i;
+    for (i = 0; i < 3; i++) {
+        flushBatch(batch, i);
+    }
+}
+
+/*
+ * Draws the cells that differ from the last presented frame, kept in shown
+ * (one byte per visible cell, 0xFF before the first frame).
+ * Returns the number of cells drawn.
+ */
+static int drawField(const Engine *engine, void *field, unsigned char *row, unsigned char *shown) {
+    static DrawBatch batch;
+    int viewWidth = lifeViewWidth();
+    int viewHeight = lifeViewHeight();
+    int drawn = 0;
+    int y;
+    for (y = 0; y < viewHeight; y++) {
+        engine->readRow(field, y, row);
+        drawn += drawRow(&batch, y, row, shown + (size_t)y * viewWidth, viewWidth);
+    }
+    flushBatches(&batch);
+    return drawn;
+}
+
+/* Same as drawField() for a frame snapshot holding the visible cells row by row. */
+static int drawFrame(const unsigned char *cells, unsigned char *shown) {
+    static DrawBatch batch;
+    int viewWidth = lifeViewWidth();
+    int viewHeight = lifeViewHeight();
+    int drawn = 0;
+    int y;
+    for (y = 0; y < viewHeight; y++) {
+        size_t offset = (size_t)y * viewWidth;
+        drawn += drawRow(&batch, y, cells + offset, shown + offset, viewWidth);
+    }
+    flushBatches(&batch);
+    return drawn;
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Copies the field into the reference engine so --verify can follow along. */
+static void copyField(const Engine *from, void *src, const Engine *to, void *dst, unsigned char *row) {
+    int y;
+    for (y = 0; y < lifeOptions.height; y++) {
+        from->readRow(src, y, row);
+        to->writeRow(dst, y, row);
+    }
+}
+
+static int differsAt(const Engine *engine, void *field, const Engine *reference, void *referenceField,
+                     unsigned char *row, unsigned char *expected) {
+    int y;
+    for (y = 0; y < lifeOptions.height; y++) {
+        engine->readRow(field, y, row);
+        reference->readRow(referenceField, y, expected);
+        if (memcmp(row, expected, lifeOptions.width) != 0) {
+            return y;
         }
+    }
+    return -1;
+}
 
-        simFlush();
+enum { CYCLE_OFF, CYCLE_STOP, CYCLE_SKIP, CYCLE_REPLAY };
+
+/* State of a run shared by the stepping code, whichever thread it is on. */
+typedef struct {
+    const Engine *engine;
+    void *field;
+    const Engine *reference;
+    void *referenceField;
+    unsigned char *row;
+    unsigned char *expected;
+    long long generation;
+    TripleBuffer frames;
+    /* Cells redrawn for the last frame the render thread presented, for --stats. */
+    atomic_int drawn;
+    atomic_int stop;
+    int cycleAction;
+    CycleDetector cycle;
+    /* Once a cycle is found: its period in frame steps and, with replay, the generation the field stays at. */
+    int period;
+    long long cycleGeneration;
+    /* Visible cells of every step of the cycle while it is replayed, NULL before. */
+    unsigned char *replay;
+    /* Generations recorded for --history, if recording is set, and the time spent stepping to pace it. */
+    History history;
+    int recording;
+    long long nextRecord;
+    long long stepped;
+    double stepSeconds;
+} Run;
 
-        if (simIsKeyDown(SIM_KEY_SPACE)) {
-            editing = 0;
+static const unsigned char *replayFrame(Run *run) {
+    size_t viewSize = (size_t)lifeViewWidth() * lifeViewHeight();
+    long long steps = (run->generation - run->cycleGeneration) >> lifeOptions.stepLog;
+    return run->replay + viewSize * (size_t)(steps % run->period);
+}
+
+/* Records the visible cells of every step of the cycle; the field is back where it started afterwards. */
+static void recordCycle(Run *run) {
+    int viewWidth = lifeViewWidth();
+    int viewHeight = lifeViewHeight();
+    size_t viewSize = (size_t)viewWidth * viewHeight;
+    int k, y;
+    run->replay = memAlloc(viewSize * run->period);
+    for (k = 0; k < run->period; k++) {
+        for (y = 0; y < viewHeight; y++) {
+            run->engine->readRow(run->field, y, run->row);
+            memcpy(run->replay + viewSize * k + (size_t)y * viewWidth, run->row, viewWidth);
         }
+        lifeAdvance(run->engine, run->field, lifeOptions.stepLog);
+    }
+    run->cycleGeneration = run->generation;
+}
 
-        int mx = simGetMouseX() / CELL_SIZE;
-        int my = simGetMouseY() / CELL_SIZE;
-        if (mx >= 0 && mx < FIELD_WIDTH && my >= 0 && my < FIELD_HEIGHT) {
-            if (simIsMouseButtonDown(SIM_MOUSE_LEFT)) {
-                current[my][mx] = ALIVE1;
-            }
-            if (simIsMouseButtonDown(SIM_MOUSE_RIGHT)) {
-                current[my][mx] = ALIVE2;
+/* Steps the field that stayed put during replay to the phase of the cycle the run ended at. */
+static void finishReplay(Run *run) {
+    long long steps;
+    if (!run->replay) {
+        return;
+    }
+    steps = ((run->generation - run->cycleGeneration) >> lifeOptions.stepLog) % run->period;
+    while (steps-- > 0) {
+        lifeAdvance(run->engine, run->field, lifeOptions.stepLog);
+    }
+    memFree(run->replay, (size_t)lifeViewWidth() * lifeViewHeight() * run->period);
+    run->replay = NULL;
+}
+
+/*
+ * Records the field for --history and schedules the next record: --history-every generations on, or
+ * with 0 as far on as keeps recording at HISTORY_OVERHEAD percent of the time spent stepping.
+ * Seeking steps at most that far, so it costs about as much as 100 / HISTORY_OVERHEAD records.
+ */
+static void record(Run *run) {
+    History *h = &run->history;
+    long long every = lifeOptions.historyEvery;
+    historyRecord(h, run->engine, run->field, run->generation, run->row);
+    if (every) {
+        run->nextRecord = (run->generation / every + 1) * every;
+    } else if (run->stepped) {
+        double budget = run->stepSeconds / run->stepped * HISTORY_OVERHEAD / 100;
+        run->nextRecord = run->generation + 1 + (long long)(h->recordSeconds / h->recorded / budget);
+    } else {
+        run->nextRecord = run->generation + 1;
+    }
+}
+
+/* Feeds the field hash to the cycle detector and acts on the first period found. */
+static void detectCycle(Run *run) {
+    long long length;
+    if (run->period) {
+        return;
+    }
+    run->period = cycleObserve(&run->cycle, lifeFieldHash(run->engine, run->field, run->row));
+    if (!run->period) {
+        return;
+    }
+    length = (long long)run->period << lifeOptions.stepLog;
+    /* Only every frame is hashed, so with --step-log the true period may be any divisor of length. */
+    if (lifeOptions.stepLog) {
+        printf("cycle: field repeats every %d frame%s of %lld generations, found at generation %lld\n", run->period,
+               run->period == 1 ? "" : "s", 1LL << lifeOptions.stepLog, run->generation);
+    } else {
+        printf("cycle: field repeats every %lld generations, found at generation %lld\n", length, run->generation);
+    }
+    if (run->cycleAction == CYCLE_STOP) {
+        atomic_store(&run->stop, 1);
+    } else if (run->cycleAction == CYCLE_SKIP) {
+        if (run->recording) {
+            /* Generations in the skipped stretch are sought as the same phase of the cycle found. */
+            historyCycle(&run->history, run->generation - length, length);
+        }
+        run->generation += (lifeOptions.generations - run->generation) / length * length;
+        if (run->recording) {
+            record(run);
+        }
+    } else if (run->cycleAction == CYCLE_REPLAY) {
+        recordCycle(run);
+    }
+}
+
+/*
+ * Advances the field by one frame step, prints --stats (frame describes the drawing side), runs --verify
+ * and looks for a cycle. A cycle being replayed only moves the generation on.
+ */
+static void advance(Run *run, const char *frame) {
+    if (run->replay) {
+        run->generation += 1LL << lifeOptions.stepLog;
+        if (lifeOptions.stats) {
+            printf("generation %lld: %s%sreplaying\n", run->generation, frame, frame[0] ? ", " : "");
+        }
+        return;
+    }
+
+    double stepStart = seconds();
+    lifeAdvance(run->engine, run->field, lifeOptions.stepLog);
+    run->generation += 1LL << lifeOptions.stepLog;
+    run->stepSeconds += seconds() - stepStart;
+    run->stepped += 1LL << lifeOptions.stepLog;
+
+    if (run->recording && run->generation >= run->nextRecord) {
+        record(run);
+    }
+
+    if (lifeOptions.checkpoint &&
+        run->generation / lifeOptions.checkpointEvery !=
+            (run->generation - (1LL << lifeOptions.stepLog)) / lifeOptions.checkpointEvery) {
+        checkpointCapture(run->engine, run->field, run->generation, run->row);
+    }
+
+    if (lifeOptions.stats) {
+        char stats[128] = "";
+        if (run->engine->stats) {
+            run->engine->stats(run->field, stats, sizeof(stats));
+        }
+        printf("generation %lld: %s%s%s\n", run->generation, frame, frame[0] && stats[0] ? ", " : "", stats);
+    }
+
+    if (run->referenceField) {
+        lifeAdvance(run->reference, run->referenceField, lifeOptions.stepLog);
+        int y = differsAt(run->engine, run->field, run->reference, run->referenceField, run->row, run->expected);
+        if (y >= 0) {
+            fprintf(stderr, "verify: %s differs from %s at generation %lld, row %d\n",
+                    run->engine->name, run->reference->name, run->generation, y);
+            exit(1);
+        }
+    }
+
+    if (run->cycleAction != CYCLE_OFF) {
+        detectCycle(run);
+    }
+}
+
+static int running(Run *run) {
+    return !atomic_load_explicit(&run->stop, memory_order_relaxed) &&
+           (!lifeOptions.generations || run->generation < lifeOptions.generations);
+}
+
+/* Copies the visible cells into the back slot of the triple buffer and publishes them. */
+static void publish(Run *run) {
+    unsigned char *cells = tripleBack(&run->frames);
+    int viewWidth = lifeViewWidth();
+    int viewHeight = lifeViewHeight();
+    int y;
+    if (run->replay) {
+        memcpy(cells, replayFrame(run), (size_t)viewWidth * viewHeight);
+    }
+    for (y = 0; y < viewHeight && !run->replay; y++) {
+        run->engine->readRow(run->field, y, run->row);
+        memcpy(cells + (size_t)y * viewWidth, run->row, viewWidth);
+    }
+    triplePublish(&run->frames, run->generation);
+}
+
+/* Achieved rates of a windowed run next to the --gps and --fps targets. */
+static void reportPacing(long long generations, int ms, long long frames) {
+    double s = ms > 0 ? ms / 1000.0 : 1e-3;
+    char target[16] = "unlimited";
+    if (lifeOptions.gps) {
+        snprintf(target, sizeof(target), "%d", lifeOptions.gps);
+    }
+    printf("pacing: %.1f generations/s (target %s), %.1f frames/s (target %d)\n",
+           generations / s, target, frames / s, lifeOptions.fps);
+}
+
+/* Simulation thread of --render-thread: keeps to --gps, or steps as fast as it can, and never waits for the display. */
+static void *simulate(void *arg) {
+    Run *run = arg;
+    char frame[96] = "";
+    long long first = run->generation;
+    int start = simGetTicks();
+    while (running(run)) {
+        if (lifeOptions.stats) {
+            snprintf(frame, sizeof(frame), "presented %lld, dropped %lld, drawn %d",
+                     (long long)atomic_load_explicit(&run->frames.presented, memory_order_relaxed),
+                     (long long)atomic_load_explicit(&run->frames.dropped, memory_order_relaxed),
+                     atomic_load_explicit(&run->drawn, memory_order_relaxed));
+        }
+        advance(run, frame);
+        publish(run);
+        if (run->replay) {
+            /* Nothing is computed any more, new frames are only needed as fast as they are shown. */
+            simDelay(1000 / lifeOptions.fps);
+        } else if (lifeOptions.gps) {
+            long long wait = start + (run->generation - first) * 1000 / lifeOptions.gps - simGetTicks();
+            if (wait > 0) {
+                simDelay((int)wait);
             }
         }
     }
-#endif
+    atomic_store(&run->stop, 1);
+    return NULL;
+}
+
+/*
+ * --render-thread: the calling thread stays the render thread and presents the
+ * newest published generation --fps times a second, the simulation runs on its own thread.
+ */
+static void runThreaded(Run *run, unsigned char *shown) {
+    pthread_t simulation;
+    int msPerFrame = 1000 / lifeOptions.fps;
+    long long first = run->generation;
+    int start = simGetTicks();
+    int last_flush_time = start;
+
+    tripleInit(&run->frames, (size_t)lifeViewWidth() * lifeViewHeight());
+    atomic_init(&run->drawn, 0);
+    atomic_init(&run->stop, 0);
+    pthread_create(&simulation, NULL, simulate, run);
 
     while (!checkFinish()) {
-        for (y = 0; y < FIELD_HEIGHT; y++) {
-            for (x = 0; x < FIELD_WIDTH; x++) {
-                int color;
-                if (current[y][x] == ALIVE1) {
-                    color = ALIVE_COLOR1;
-                } else if (current[y][x] == ALIVE2) {
-                    color = ALIVE_COLOR2;
-                } else {
-                    color = DEAD_COLOR;
-                }
-                simFillRect(x * CELL_SIZE, y * CELL_SIZE, CELL_SIZE, CELL_SIZE, color);
-            }
+        int finished = atomic_load(&run->stop);
+        const unsigned char *cells = tripleAcquire(&run->frames, NULL);
+        if (cells) {
+            atomic_store_explicit(&run->drawn, drawFrame(cells, shown), memory_order_relaxed);
+        } else if (finished) {
+            break;
         }
 
         int current_time = simGetTicks();
         int elapsed = current_time - last_flush_time;
-        if (elapsed < MS_PER_GENERATION) {
-            simDelay(MS_PER_GENERATION - elapsed);
+        if (elapsed < msPerFrame) {
+            simDelay(msPerFrame - elapsed);
         }
         simFlush();
         last_flush_time = simGetTicks();
+    }
 
-        for (y = 0; y < FIELD_HEIGHT; y++) {
-            for (x = 0; x < FIELD_WIDTH; x++) {
-                int neighbors = 0;
-                int count1 = 0;
-                int count2 = 0;
-                int dy, dx;
-                for (dy = -1; dy <= 1; dy++) {
-                    for (dx = -1; dx <= 1; dx++) {
-                        if (dy == 0 && dx == 0) continue;
-                        int ny = (y + dy + FIELD_HEIGHT) % FIELD_HEIGHT;
-                        int nx = (x + dx + FIELD_WIDTH) % FIELD_WIDTH;
-                        if (current[ny][nx] == ALIVE1) {
-                            neighbors++;
-                            count1++;
-                        } else if (current[ny][nx] == ALIVE2) {
-                            neighbors++;
-                            count2++;
-                        }
-                    }
-                }
-                if (current[y][x] > DEAD) {
-                    if (neighbors == 2 || neighbors == 3) {
-                        next[y][x] = current[y][x];
-                    } else {
-                        next[y][x] = DEAD;
-                    }
-                } else {
-                    if (neighbors == 3) {
-                        if (count1 > count2) {
-                            next[y][x] = ALIVE1;
-                        } else {
-                            next[y][x] = ALIVE2;
-                        }
-                    } else {
-                        next[y][x] = DEAD;
-                    }
+    atomic_store(&run->stop, 1);
+    pthread_join(simulation, NULL);
+    printf("frames: %lld presented, %lld dropped\n",
+           (long long)atomic_load(&run->frames.presented), (long long)atomic_load(&run->frames.dropped));
+    reportPacing(run->generation - first, simGetTicks() - start, atomic_load(&run->frames.presented));
+    tripleFree(&run->frames);
+}
+
+/*
+ * While the left or right arrow key is held, goes one frame step back or forward in the history per
+ * frame. Cycle detection starts over and --verify follows from the generation shown. Returns 1 while browsing.
+ */
+static int browse(Run *run) {
+    long long target;
+    if (!run->recording || run->replay) {
+        return 0;
+    }
+    if (simIsKeyDown(SIM_KEY_LEFT)) {
+        target = run->generation - (1LL << lifeOptions.stepLog);
+    } else if (simIsKeyDown(SIM_KEY_RIGHT)) {
+        target = run->generation + (1LL << lifeOptions.stepLog);
+    } else {
+        return 0;
+    }
+    if (historySeek(&run->history, run->engine, run->field, run->generation, target, run->row) == 0) {
+        run->generation = target;
+        run->nextRecord = target + 1;
+        memset(&run->cycle, 0, sizeof(run->cycle));
+        if (run->referenceField) {
+            copyField(run->engine, run->field, run->reference, run->referenceField, run->row);
+        }
+    }
+    return 1;
+}
+
+/*
+ * The window on a single thread. Between two presents it steps every frame step the --gps schedule
+ * has made due, in one batch, and sleeps when it is ahead. A present that comes due while the
+ * simulation is more than a frame's worth of generations behind is skipped, so a slow host
+ * drops frames instead of slowing the simulation down.
+ */
+static void runPaced(Run *run, unsigned char *shown) {
+    long long first = run->generation;
+    double msPerFrame = 1000.0 / lifeOptions.fps;
+    double perFrame = (double)lifeOptions.gps / lifeOptions.fps;
+    int start = simGetTicks();
+    double nextFrame = start;
+    long long frames = 0;
+    long long skipped = 0;
+    int skippedInRow = 0;
+    int browsing = 0;
+    char frame[32] = "";
+    /* The --gps schedule counts from here, it starts over after browsing the history. */
+    long long base = first;
+    int baseTime = start;
+
+    while (!checkFinish() && running(run)) {
+        int now = simGetTicks();
+        /* Generation the schedule has reached by now. */
+        long long target = lifeOptions.gps ? base + (long long)(now - baseTime) * lifeOptions.gps / 1000 : LLONG_MAX;
+
+        if (now >= nextFrame) {
+            browsing = browse(run);
+            if (browsing) {
+                base = run->generation;
+                baseTime = now;
+            }
+            if (!browsing && lifeOptions.gps && target - run->generation > perFrame && skippedInRow < MAX_SKIPPED_FRAMES) {
+                skipped++;
+                skippedInRow++;
+            } else {
+                int drawn = run->replay ? drawFrame(replayFrame(run), shown)
+                                        : drawField(run->engine, run->field, run->row, shown);
+                simFlush();
+                frames++;
+                skippedInRow = 0;
+                if (lifeOptions.stats) {
+                    snprintf(frame, sizeof(frame), "drawn %d", drawn);
                 }
             }
+            nextFrame += msPerFrame;
+            if (nextFrame < now) {
+                nextFrame = now + msPerFrame;
+            }
+            continue;
+        }
+
+        if (browsing) {
+            simDelay(nextFrame - now > 1 ? (int)(nextFrame - now) : 1);
+        } else if (run->generation < target) {
+            do {
+                advance(run, frame);
+            } while (running(run) && run->generation < target && simGetTicks() < nextFrame);
+        } else {
+            double wake = baseTime + (double)(run->generation - base + 1) * 1000 / lifeOptions.gps;
+            if (wake > nextFrame) {
+                wake = nextFrame;
+            }
+            simDelay(wake - now > 1 ? (int)(wake - now) : 1);
+        }
+    }
+
+    printf("frames: %lld presented, %lld skipped\n", frames, skipped);
+    reportPacing(run->generation - first, simGetTicks() - start, frames);
+}
+
+#define FILL_ROWS 64
+
+/* Rows of the random field drawn in parallel before they are handed to the engine one by one. */
+typedef struct {
+    unsigned char *rows;
+    int width;
+    int y0;
+} RandomRows;
+
+static void randomBand(void *ctx, int r0, int r1) {
+    RandomRows *fill = ctx;
+    uint64_t numbers[256];
+    uint64_t seed = (uint64_t)lifeOptions.seed;
+    int r, x, i;
+    for (r = r0; r < r1; r++) {
+        unsigned char *cells = fill->rows + (size_t)r * fill->width;
+        uint64_t counter = (uint64_t)(fill->y0 + r) * fill->width;
+        for (x = 0; x < fill->width; x += 256) {
+            int n = fill->width - x < 256 ? fill->width - x : 256;
+            simRandomFill(seed, counter + x, numbers, n);
+            /* The low half picks life with ALIVE_PROB percent, the top bit the color. */
+            for (i = 0; i < n; i++) {
+                unsigned char alive = ((numbers[i] & 0xFFFFFFFFu) * 100 >> 32) < ALIVE_PROB;
+                cells[x + i] = (unsigned char)(alive * (ALIVE1 + (numbers[i] >> 63)));
+            }
         }
+    }
+}
+
+/* Fills the field from the --seed stream, FILL_ROWS rows at a time across the pool. */
+static void randomField(const Engine *engine, void *field, int width, int height) {
+    RandomRows fill;
+    int y;
+    fill.width = width;
+    fill.rows = memAlloc((size_t)FILL_ROWS * width);
+    for (fill.y0 = 0; fill.y0 < height; fill.y0 += FILL_ROWS) {
+        int rows = height - fill.y0 < FILL_ROWS ? height - fill.y0 : FILL_ROWS;
+        poolRun(randomBand, &fill, rows);
+        for (y = 0; y < rows; y++) {
+            engine->writeRow(field, fill.y0 + y, fill.rows + (size_t)y * width);
+        }
+    }
+    memFree(fill.rows, (size_t)FILL_ROWS * width);
+}
+
+#if EDITOR_MODE
+/* Sets the cell under a mouse event to the color of its button, drawing it only if it changed. */
+static void editCell(const Engine *engine, void *field, unsigned char *row, unsigned char *shown, DrawBatch *batch,
+                     const SimEvent *event) {
+    int x = event->x / CELL_SIZE;
+    int y = event->y / CELL_SIZE;
+    unsigned char cell;
+    if (event->buttons & SIM_MOUSE_MASK(SIM_MOUSE_LEFT)) {
+        cell = ALIVE1;
+    } else if (event->buttons & SIM_MOUSE_MASK(SIM_MOUSE_RIGHT)) {
+        cell = ALIVE2;
+    } else {
+        return;
+    }
+    if (x < 0 || x >= lifeViewWidth() || y < 0 || y >= lifeViewHeight()) {
+        return;
+    }
+    engine->readRow(field, y, row);
+    if (row[x] == cell) {
+        return;
+    }
+    row[x] = cell;
+    engine->writeRow(field, y, row);
+    drawCell(batch, x, y, cell);
+    shown[(size_t)y * lifeViewWidth() + x] = cell;
+}
 
-        for (y = 0; y < FIELD_HEIGHT; y++) {
-            for (x = 0; x < FIELD_WIDTH; x++) {
-                current[y][x] = next[y][x];
+/*
+ * Lets the user draw the initial field until space is pressed or the window is closed.
+ * The loop sleeps in simWaitEvent(); every wakeup drains the queued events, draws only
+ * the cells they changed and presents once.
+ */
+static void edit(const Engine *engine, void *field, unsigned char *row, unsigned char *shown) {
+    static DrawBatch batch;
+    SimEvent event;
+    int editing = 1;
+    drawField(engine, field, row, shown);
+    simFlush();
+    while (editing) {
+        if (!simWaitEvent(&event, EDITOR_WAIT_MS)) {
+            continue;
+        }
+        do {
+            if (event.type == SIM_EVENT_QUIT || (event.type == SIM_EVENT_KEY && event.key == SIM_KEY_SPACE)) {
+                editing = 0;
+            } else if (event.type == SIM_EVENT_MOUSE) {
+                editCell(engine, field, row, shown, &batch, &event);
             }
+        } while (editing && simWaitEvent(&event, 0));
+        flushBatches(&batch);
+        simFlush();
+    }
+}
+#endif
+
+void app() {
+    const Engine *engine = lifeFindEngine(lifeOptions.engine);
+    poolStart(lifeOptions.threads);
+    int width = lifeOptions.width;
+    int height = lifeOptions.height;
+    void *field = engine->create(width, height);
+    unsigned char *row = memAlloc(width);
+    size_t shownSize = (size_t)lifeViewWidth() * lifeViewHeight();
+    unsigned char *shown = memAlloc(shownSize);
+
+    memset(shown, 0xFF, shownSize);
+
+    printf("%s engine, rule %s, %dx%d field, %.1f MiB allocated, %.1f MiB on huge pages\n",
+           engine->name, lifeOptions.rule, width, height, memFootprint() / 1048576.0, memHugeFootprint() / 1048576.0);
+
+    Run run = {0};
+    if (lifeOptions.resume) {
+        if (checkpointRestore(lifeOptions.resume, engine, field, row, &run.generation) != 0) {
+            exit(1);
+        }
+        printf("resumed %s at generation %lld\n", lifeOptions.resume, run.generation);
+    }
+
+    if (lifeOptions.load) {
+        double loadStart = seconds();
+        if (patternLoad(lifeOptions.load, engine, field, width, height, row) != 0) {
+            exit(1);
+        }
+        printf("loaded %s in %.3f s\n", lifeOptions.load, seconds() - loadStart);
+    }
+
+#if RANDOM_INIT
+    if (!lifeOptions.load && !lifeOptions.resume) {
+        double fillStart = seconds();
+        randomField(engine, field, width, height);
+        printf("random field, seed %lld, in %.3f s\n", lifeOptions.seed, seconds() - fillStart);
+    }
+#endif
+
+#if EDITOR_MODE
+    edit(engine, field, row, shown);
+#endif
+
+    run.engine = engine;
+    run.field = field;
+    run.reference = &denseEngine;
+    run.row = row;
+    if (lifeOptions.verify) {
+        run.referenceField = run.reference->create(width, height);
+        run.expected = memAlloc(width);
+        copyField(engine, field, run.reference, run.referenceField, row);
+    }
+
+    if (lifeOptions.checkpoint) {
+        checkpointStart(lifeOptions.checkpoint, width, height);
+    }
+
+    run.cycleAction = strcmp(lifeOptions.cycle, "stop") == 0     ? CYCLE_STOP
+                      : strcmp(lifeOptions.cycle, "skip") == 0   ? CYCLE_SKIP
+                      : strcmp(lifeOptions.cycle, "replay") == 0 ? CYCLE_REPLAY
+                                                                 : CYCLE_OFF;
+    if (run.cycleAction != CYCLE_OFF) {
+        cycleObserve(&run.cycle, lifeFieldHash(engine, field, row));
+    }
+
+    if (lifeOptions.history) {
+        if (historyInit(&run.history, width, height, (size_t)lifeOptions.history << 20, lifeOptions.keyframeEvery) != 0) {
+            fprintf(stderr, "--history %d MiB cannot hold two generations of a %dx%d field\n", lifeOptions.history,
+                    width, height);
+            exit(1);
+        }
+        run.recording = 1;
+        record(&run);
+    }
+
+    long long firstGeneration = run.generation;
+    double start = seconds();
+    if (lifeOptions.bench) {
+        while (!checkFinish() && running(&run)) {
+            advance(&run, "");
+        }
+    } else if (lifeOptions.renderThread) {
+        runThreaded(&run, shown);
+    } else {
+        runPaced(&run, shown);
+    }
+
+    double elapsed = seconds() - start;
+    long long generation = run.generation - firstGeneration;
+    finishReplay(&run);
+
+    if (lifeOptions.seek >= 0) {
+        if (historySeek(&run.history, engine, field, run.generation, lifeOptions.seek, row) != 0) {
+            fprintf(stderr, "generation %lld is not in the history, it holds %lld..%lld\n", lifeOptions.seek,
+                    historyOldest(&run.history), historyNewest(&run.history));
+            exit(1);
         }
+        run.generation = lifeOptions.seek;
+        printf("went back to generation %lld\n", run.generation);
+    }
+    if (run.recording) {
+        historyReport(&run.history, run.stepSeconds);
+        historyFree(&run.history);
+    }
+
+    if (lifeOptions.checkpoint) {
+        checkpointCapture(engine, field, run.generation, row);
+        checkpointStop();
+    }
+
+    if (lifeOptions.bench) {
+        printf("bench: %lld generations in %.3f s, %.1f generations/s, %.3f ns/cell, hash %016llx\n",
+               generation, elapsed, generation / elapsed,
+               elapsed * 1e9 / ((double)generation * width * height),
+               (unsigned long long)lifeHash(engine, field, width, height, row));
+    }
+
+    if (lifeOptions.save && patternSave(lifeOptions.save, engine, field, width, height, row) != 0) {
+        exit(1);
+    }
+
+    if (run.referenceField) {
+        run.reference->destroy(run.referenceField);
+        memFree(run.expected, width);
     }
-}
\ No newline at end of file
+    memFree(shown, shownSize);
+    memFree(row, width);
+    engine->destroy(field);
+    poolStop();
+}
@@ -0,0 +1,29 @@
+#include <string.h>
+#include "grid.h"
+#include "mem.h"
+
+void haloInit(HaloGrid *g, int width, int height) {
+    g->width = width;
+    g->height = height;
+    g->stride = (width + 2 + 63) & ~63;
+    g->cells = memAlloc((size_t)(height + 2) * g->stride);
+}
+
+void haloFree(HaloGrid *g) {
+    memFree(g->cells, (size_t)(g->height + 2) * g->stride);
+    g->cells = NULL;
+}
+
+void haloRefresh(HaloGrid *g) {
+    int width = g->width;
+    int y;
+
+    for (y = 0; y < g->height; y++) {
+        unsigned char *row = haloRow(g, y);
+        row[-1] = row[width - 1];
+        row[width] = row[0];
+    }
+    /* Whole rows including the halo columns, which also fills the corners. */
+    memcpy(haloRow(g, -1) - 1, haloRow(g, g->height - 1) - 1, width + 2);
+    memcpy(haloRow(g, g->height) - 1, haloRow(g, 0) - 1, width + 2);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __grid__
+#define __grid__
+
+#include <stddef.h>
+
+/*
+ * Byte grid surrounded by a one-cell halo.
+ * The halo mirrors the opposite edges of the torus, so after haloRefresh()
+ * every cell can read its eight neighbors at x-1..x+1, y-1..y+1 without any wraparound.
+ * Rows are padded to a multiple of 64 bytes.
+ */
+typedef struct {
+    int width;
+    int height;
+    int stride;
+    unsigned char *cells;
+} HaloGrid;
+
+void haloInit(HaloGrid *g, int width, int height);
+void haloFree(HaloGrid *g);
+void haloRefresh(HaloGrid *g);
+
+/* Row y of the field, valid for y = -1..height and x = -1..width. */
+static inline unsigned char *haloRow(const HaloGrid *g, int y) {
+    return g->cells + (size_t)(y + 1) * g->stride + 1;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "history.h"
+#include "mem.h"
+
+/*
+ * A record is the XOR of the field with the one before, packed: a bitmap of the words that
+ * differ, then those words in order. The bitmap is mostly empty, so it is stored run-length
+ * encoded as tokens, each followed by its literal bitmap words: the token holds the number of
+ * zero words to skip in its high half and the number of literals in its low half. The first
+ * word of a record is the length of the encoded bitmap.
+ */
+typedef struct {
+    uint64_t *out;
+    size_t words;
+    size_t token;
+    uint64_t skip;
+    uint64_t literals;
+} Encoder;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void encodeStart(Encoder *e, uint64_t *out) {
+    e->out = out;
+    e->words = 1;
+    e->token = 0;
+    e->skip = 0;
+    e->literals = 0;
+}
+
+static void encode(Encoder *e, uint64_t word) {
+    if (word) {
+        e->out[e->words++] = word;
+        e->literals++;
+    } else if (!e->literals) {
+        e->skip++;
+    } else {
+        e->out[e->token] = e->skip << 32 | e->literals;
+        e->token = e->words++;
+        e->skip = 1;
+        e->literals = 0;
+    }
+}
+
+static size_t encodeFinish(Encoder *e) {
+    if (!e->literals) {
+        return e->words - 1;
+    }
+    e->out[e->token] = e->skip << 32 | e->literals;
+    return e->words;
+}
+
+static size_t bitmapWords(const History *h) {
+    return (h->frameWords + 63) / 64;
+}
+
+/* Longest encoding of the bitmap: one token per two words on top of the words themselves. */
+static size_t maxRecordWords(const History *h) {
+    return 1 + bitmapWords(h) + bitmapWords(h) / 2 + 2 + h->frameWords;
+}
+
+/* XORs a record into a packed field. */
+static void decode(uint64_t *field, const uint64_t *record) {
+    const uint64_t *bitmap = record + 1;
+    const uint64_t *literals = bitmap + record[0];
+    size_t i = 0;
+    size_t at = 0;
+    while (i < record[0]) {
+        uint64_t token = bitmap[i++];
+        uint64_t count = token & 0xFFFFFFFFu;
+        at += token >> 32;
+        while (count--) {
+            uint64_t mask = bitmap[i++];
+            while (mask) {
+                field[at * 64 + __builtin_ctzll(mask)] ^= *literals++;
+                mask &= mask - 1;
+            }
+            at++;
+        }
+    }
+}
+
+/*
+ * Packs a row at 32 cells per word: bit x of the low half holds the low bit of cell x,
+ * bit x of the high half its high bit.
+ */
+static void packRow(const unsigned char *row, int width, uint64_t *words) {
+    int w, x;
+    for (w = 0; (w + 1) * 32 <= width; w++) {
+        const unsigned char *cells = row + w * 32;
+#ifdef __SSE2__
+        __m128i a = _mm_loadu_si128((const __m128i *)cells);
+        __m128i b = _mm_loadu_si128((const __m128i *)(cells + 16));
+        uint64_t low = (uint32_t)(_mm_movemask_epi8(_mm_slli_epi16(a, 7)) | _mm_movemask_epi8(_mm_slli_epi16(b, 7)) << 16);
+        uint64_t high = (uint32_t)(_mm_movemask_epi8(_mm_slli_epi16(a, 6)) | _mm_movemask_epi8(_mm_slli_epi16(b, 6)) << 16);
+        words[w] = low | high << 32;
+#else
+        uint64_t word = 0;
+        int i;
+        for (i = 0; i < 4; i++) {
+            uint64_t v;
+            memcpy(&v, cells + i * 8, 8);
+            word |= ((v & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56 << (i * 8);
+            word |= ((v >> 1 & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56 << (32 + i * 8);
+        }
+        words[w] = word;
+#endif
+    }
+    if (w * 32 < width) {
+        words[w] = 0;
+        for (x = w * 32; x < width; x++) {
+            words[w] |= (uint64_t)(row[x] & 1) << (x & 31) | (uint64_t)(row[x] >> 1) << (32 + (x & 31));
+        }
+    }
+}
+
+/* Spreads 8 bits into the low bit of 8 bytes. */
+static inline uint64_t spread(uint64_t bits) {
+    uint64_t v = ((bits & 0xFF) * 0x0101010101010101ull) & 0x8040201008040201ull;
+    return ((v + 0x7F7F7F7F7F7F7F7Full) >> 7) & 0x0101010101010101ull;
+}
+
+static void unpackRow(const uint64_t *words, int width, unsigned char *row) {
+    int w, x, i;
+    for (w = 0; (w + 1) * 32 <= width; w++) {
+        for (i = 0; i < 4; i++) {
+            uint64_t v = spread(words[w] >> (i * 8)) | spread(words[w] >> (32 + i * 8)) << 1;
+            memcpy(row + w * 32 + i * 8, &v, 8);
+        }
+    }
+    for (x = w * 32; x < width; x++) {
+        row[x] = (unsigned char)((words[w] >> (x & 31) & 1) | (words[w] >> (32 + (x & 31)) & 1) << 1);
+    }
+}
+
+/* Adds words packed words at word at of the field to the record being built, branch free. */
+static void diff(History *h, size_t at, const uint64_t *packed, size_t words, int key) {
+    uint64_t *current = h->current + at;
+    uint64_t *literals = h->literals;
+    size_t count = h->literalCount;
+    uint64_t bits = 0;
+    size_t i;
+    for (i = 0; i < words; i++) {
+        uint64_t d = key ? packed[i] : packed[i] ^ current[i];
+        literals[count] = d;
+        count += d != 0;
+        bits |= (uint64_t)(d != 0) << ((at + i) & 63);
+        current[i] = packed[i];
+        if (((at + i) & 63) == 63) {
+            h->bitmap[(at + i) >> 6] |= bits;
+            bits = 0;
+        }
+    }
+    if (bits) {
+        h->bitmap[(at + words - 1) >> 6] |= bits;
+    }
+    h->literalCount = count;
+}
+
+static HistoryRecord *recordAt(const History *h, int i) {
+    return &h->records[(h->first + i) % h->capacity];
+}
+
+/* Index of the first retained record at or after generation, count if there is none. */
+static int lowerBound(const History *h, long long generation) {
+    int lo = 0;
+    int hi = h->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (recordAt(h, mid)->generation < generation) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Drops the oldest keyframe and the deltas built on it. */
+static void evictOldest(History *h) {
+    do {
+        h->first = (h->first + 1) % h->capacity;
+        h->count--;
+    } while (h->count && recordAt(h, 0)->sinceKey);
+}
+
+/* Finds room for words contiguous words after the newest record, evicting the oldest ones as needed. */
+static size_t reserve(History *h, size_t words) {
+    while (h->count) {
+        size_t head = recordAt(h, 0)->offset;
+        const HistoryRecord *newest = recordAt(h, h->count - 1);
+        size_t tail = newest->offset + newest->words;
+        if (newest->offset >= head) {
+            if (h->ringWords - tail >= words) {
+                return tail;
+            }
+            if (head >= words) {
+                return 0;
+            }
+        } else if (head - tail >= words) {
+            return tail;
+        }
+        evictOldest(h);
+    }
+    return 0;
+}
+
+int historyInit(History *h, int width, int height, size_t budget, int keyframeEvery) {
+    memset(h, 0, sizeof(History));
+    h->width = width;
+    h->height = height;
+    h->rowWords = (width + 31) / 32;
+    h->keyframeEvery = keyframeEvery;
+    h->frameWords = (size_t)h->rowWords * height;
+    h->ringWords = budget / sizeof(uint64_t);
+    if (h->ringWords < 2 * maxRecordWords(h)) {
+        return -1;
+    }
+    h->current = memAlloc(h->frameWords * sizeof(uint64_t));
+    h->packed = memAlloc(h->rowWords * sizeof(uint64_t));
+    h->bitmap = memAlloc(bitmapWords(h) * sizeof(uint64_t));
+    h->literals = memAlloc(h->frameWords * sizeof(uint64_t));
+    h->scratch = memAlloc((maxRecordWords(h) - h->frameWords) * sizeof(uint64_t));
+    h->ring = memAlloc(h->ringWords * sizeof(uint64_t));
+    return 0;
+}
+
+void historyFree(History *h) {
+    if (!h->ring) {
+        return;
+    }
+    memFree(h->current, h->frameWords * sizeof(uint64_t));
+    memFree(h->packed, h->rowWords * sizeof(uint64_t));
+    memFree(h->bitmap, bitmapWords(h) * sizeof(uint64_t));
+    memFree(h->literals, h->frameWords * sizeof(uint64_t));
+    memFree(h->scratch, (maxRecordWords(h) - h->frameWords) * sizeof(uint64_t));
+    memFree(h->ring, h->ringWords * sizeof(uint64_t));
+    free(h->records);
+    h->ring = NULL;
+}
+
+/* Run-length encodes the bitmap of the record being built and copies the record into the ring. */
+static size_t store(History *h, size_t *words) {
+    Encoder e;
+    size_t i, offset;
+    encodeStart(&e, h->scratch + 1);
+    for (i = 0; i < bitmapWords(h); i++) {
+        encode(&e, h->bitmap[i]);
+    }
+    h->scratch[0] = encodeFinish(&e);
+    *words = 1 + h->scratch[0] + h->literalCount;
+    offset = reserve(h, *words);
+    memcpy(h->ring + offset, h->scratch, (1 + h->scratch[0]) * sizeof(uint64_t));
+    memcpy(h->ring + offset + 1 + h->scratch[0], h->literals, h->literalCount * sizeof(uint64_t));
+    return offset;
+}
+
+static void startRecord(History *h) {
+    memset(h->bitmap, 0, bitmapWords(h) * sizeof(uint64_t));
+    h->literalCount = 0;
+}
+
+void historyRecord(History *h, const Engine *engine, void *field, long long generation, unsigned char *row) {
+    double start = now();
+    HistoryRecord *record;
+    size_t words, offset;
+    int key, y, j;
+
+    /* After seeking back, the records past the one the field was rebuilt from are another future. */
+    while (h->count && (recordAt(h, h->count - 1)->generation >= generation ||
+                        recordAt(h, h->count - 1)->generation > h->base)) {
+        h->count--;
+    }
+    key = h->keyNext || !h->count || recordAt(h, h->count - 1)->sinceKey + 1 >= h->keyframeEvery;
+    h->keyNext = 0;
+
+    /* Packing and diffing in one pass over the rows, so the field is read once. */
+    startRecord(h);
+    for (y = 0; y < h->height; y++) {
+        engine->readRow(field, y, row);
+        packRow(row, h->width, h->packed);
+        diff(h, (size_t)y * h->rowWords, h->packed, h->rowWords, key);
+    }
+    offset = store(h, &words);
+    if (!h->count && !key) {
+        /* Making room took the keyframe this delta builds on, store the whole field instead. */
+        key = 1;
+        startRecord(h);
+        diff(h, 0, h->current, h->frameWords, 1);
+        offset = store(h, &words);
+    }
+
+    if (h->count == h->capacity) {
+        int capacity = h->capacity ? h->capacity * 2 : 1024;
+        HistoryRecord *records = malloc(sizeof(HistoryRecord) * capacity);
+        for (j = 0; j < h->count; j++) {
+            records[j] = *recordAt(h, j);
+        }
+        free(h->records);
+        h->records = records;
+        h->capacity = capacity;
+        h->first = 0;
+    }
+    record = recordAt(h, h->count);
+    record->generation = generation;
+    record->offset = offset;
+    record->words = words;
+    record->sinceKey = key ? 0 : recordAt(h, h->count - 1)->sinceKey + 1;
+    h->count++;
+    h->base = generation;
+
+    h->recorded++;
+    h->recordSeconds += now() - start;
+}
+
+int historySeek(History *h, const Engine *engine, void *field, long long generation, long long target,
+                unsigned char *row) {
+    const HistoryRecord *from;
+    long long steps;
+    int i, j, k, y;
+    if (h->count && generation > recordAt(h, h->count - 1)->generation && h->base == recordAt(h, h->count - 1)->generation) {
+        historyRecord(h, engine, field, generation, row);
+    }
+    if (target < historyOldest(h) || target > historyNewest(h)) {
+        return -1;
+    }
+    i = lowerBound(h, target + 1) - 1;
+    from = recordAt(h, i);
+    steps = target - from->generation;
+    /* Whichever record the field is rebuilt from, the records up to target stay its past. */
+    h->base = from->generation;
+    h->keyNext = 0;
+    if (h->cycleLength && target > h->cycleStart) {
+        /* Right after skipping a cycle the record before target is all the skipped generations away. */
+        long long phase = h->cycleStart + (target - h->cycleStart) % h->cycleLength;
+        j = lowerBound(h, phase + 1) - 1;
+        if (j >= 0 && phase - recordAt(h, j)->generation < steps) {
+            steps = phase - recordAt(h, j)->generation;
+            h->keyNext = j != i;
+            i = j;
+            from = recordAt(h, i);
+        }
+    }
+    memset(h->current, 0, h->frameWords * sizeof(uint64_t));
+    for (k = i - from->sinceKey; k <= i; k++) {
+        decode(h->current, h->ring + recordAt(h, k)->offset);
+    }
+    for (y = 0; y < h->height; y++) {
+        unpackRow(h->current + (size_t)y * h->rowWords, h->width, row);
+        engine->writeRow(field, y, row);
+    }
+    /* Generations between two records are stepped again, in the largest jumps the engine takes. */
+    for (k = 62; k >= 0; k--) {
+        if (steps >> k & 1) {
+            lifeAdvance(engine, field, k);
+        }
+    }
+    return 0;
+}
+
+long long historyOldest(const History *h) {
+    return h->count ? recordAt(h, 0)->generation : -1;
+}
+
+long long historyNewest(const History *h) {
+    return h->count ? recordAt(h, h->count - 1)->generation : -1;
+}
+
+void historyCycle(History *h, long long start, long long length) {
+    h->cycleStart = start;
+    h->cycleLength = length;
+}
+
+void historyReport(const History *h, double stepSeconds) {
+    size_t used = 0;
+    int keyframes = 0;
+    int i;
+    if (!h->count) {
+        return;
+    }
+    for (i = 0; i < h->count; i++) {
+        used += recordAt(h, i)->words;
+        keyframes += !recordAt(h, i)->sinceKey;
+    }
+    printf("history: generations %lld..%lld in %d records (%d keyframes), %.1f of %.1f MiB, %.3f ms per record",
+           recordAt(h, 0)->generation, recordAt(h, h->count - 1)->generation, h->count, keyframes,
+           used * sizeof(uint64_t) / 1048576.0, h->ringWords * sizeof(uint64_t) / 1048576.0,
+           h->recordSeconds * 1e3 / h->recorded);
+    if (stepSeconds > 0) {
+        printf(", %.1f%% of the stepping time", h->recordSeconds * 100 / stepSeconds);
+    }
+    printf("\n");
+}
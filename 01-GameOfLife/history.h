@@ -0,0 +1,97 @@
+#ifndef __history__
+#define __history__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "life.h"
+
+/*
+ * Recorded generations of a run, to step back through. Every record is the field at
+ * 2 bits per cell XORed with the record before, stored as a run-length encoded bitmap
+ * of the words that changed and those words. Every keyframeEvery-th record is XORed with
+ * an empty field instead, so a record is rebuilt from the keyframe before it and at most
+ * keyframeEvery - 1 deltas.
+ * Generations between two records are stepped again from the one before, so recording
+ * only every few generations still lets any of them be sought.
+ * Records live in a ring of a fixed byte budget: when it is full the oldest keyframe
+ * goes, together with the deltas that depend on it.
+ */
+typedef struct {
+    long long generation;
+    size_t offset;
+    size_t words;
+    /* Records since the last keyframe, 0 for a keyframe. */
+    int sinceKey;
+} HistoryRecord;
+
+typedef struct {
+    int width;
+    int height;
+    int rowWords;
+    int keyframeEvery;
+
+    /* Last recorded (or sought) field packed, and the row being packed. */
+    uint64_t *current;
+    uint64_t *packed;
+    /* Record being built: bitmap of the changed words, the words, and the encoded bitmap. */
+    uint64_t *bitmap;
+    uint64_t *literals;
+    size_t literalCount;
+    uint64_t *scratch;
+    size_t frameWords;
+
+    uint64_t *ring;
+    size_t ringWords;
+
+    /* Oldest record first, at records[(first + i) % capacity]. */
+    HistoryRecord *records;
+    int first;
+    int count;
+    int capacity;
+
+    /* Generation of the record the field was last recorded as or rebuilt from. */
+    long long base;
+    /* Set when current holds another record than the one at base, so the next record cannot be a delta. */
+    int keyNext;
+
+    /* Once the run skipped over a cycle: from cycleStart on the field repeats every cycleLength generations. */
+    long long cycleStart;
+    long long cycleLength;
+
+    long long recorded;
+    double recordSeconds;
+} History;
+
+/* Returns 0, or -1 if budget bytes cannot hold two records of the worst case size. */
+int historyInit(History *h, int width, int height, size_t budget, int keyframeEvery);
+void historyFree(History *h);
+
+/*
+ * Appends the field as the given generation. Records after the one the field was last
+ * rebuilt from by historySeek() are dropped first: stepping on from there overwrites them.
+ */
+void historyRecord(History *h, const Engine *engine, void *field, long long generation, unsigned char *row);
+
+/*
+ * Puts the field, now at generation, back to target: rebuilds the last record at or before it
+ * and steps the rest of the way. A generation newer than every record is recorded first, so
+ * seeking can come back to it. Past the start of a cycle given to historyCycle(), target may be
+ * rebuilt as the same phase of an earlier repetition instead, whichever is fewer steps away.
+ * Returns 0, or -1 if target is outside the retained range.
+ */
+int historySeek(History *h, const Engine *engine, void *field, long long generation, long long target,
+                unsigned char *row);
+
+/* Retained range: every generation from the oldest to the newest record can be sought, -1 if there is none. */
+long long historyOldest(const History *h);
+long long historyNewest(const History *h);
+
+/*
+ * Notes that the field repeats every length generations from start on, e.g. when the generation
+ * count jumps over whole repetitions without stepping them. Records on both sides of the jump stay.
+ */
+void historyCycle(History *h, long long start, long long length);
+
+/* Prints the retained range, memory in use and the time spent recording, relative to stepSeconds if positive. */
+void historyReport(const History *h, double stepSeconds);
+#endif
@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "life.h"
+#include "checkpoint.h"
+
+struct LifeOptions lifeOptions = {
+    FIELD_WIDTH,
+    FIELD_HEIGHT,
+    ENGINE,
+    KERNEL,
+    THREADS,
+    STEP_LOG,
+    HASHLIFE_MEMORY,
+    0,
+    TILE_SIZE,
+    0,
+    0,
+    0,
+    0,
+    RENDER_THREAD,
+    RULE,
+    NULL,
+    NULL,
+    NULL,
+    CHECKPOINT_EVERY,
+    NULL,
+    CYCLE,
+    BLOCK,
+    TEMPORAL_STEPS,
+    TARGET_GPS,
+    TARGET_FPS,
+    HISTORY_MEMORY,
+    HISTORY_EVERY,
+    HISTORY_KEYFRAME_EVERY,
+    -1,
+};
+
+LifeRule lifeRule = {1 << 3, 1 << 2 | 1 << 3};
+
+static const Engine *engines[] = {
+    &denseEngine,
+    &bitplaneEngine,
+    &vectorEngine,
+    &hashlifeEngine,
+    &planeEngine,
+};
+
+#define ENGINE_COUNT ((int)(sizeof(engines) / sizeof(engines[0])))
+
+const Engine *lifeFindEngine(const char *name) {
+    int i;
+    for (i = 0; i < ENGINE_COUNT; i++) {
+        if (strcmp(engines[i]->name, name) == 0) {
+            return engines[i];
+        }
+    }
+    return NULL;
+}
+
+int lifeParseRule(const char *text, LifeRule *rule) {
+    int masks[2] = {0, 0};
+    int seen[2] = {0, 0};
+    int *mask = NULL;
+    const char *p;
+    for (p = text; *p; p++) {
+        if (*p == 'B' || *p == 'b' || *p == 'S' || *p == 's') {
+            int which = *p == 'S' || *p == 's';
+            if (seen[which] || (mask && p[-1] != '/') || (!mask && p != text)) {
+                return -1;
+            }
+            seen[which] = 1;
+            mask = &masks[which];
+        } else if (*p >= '0' && *p <= '8' && mask) {
+            *mask |= 1 << (*p - '0');
+        } else if (*p != '/' || !mask || p[-1] == '/' || p[1] == '\0') {
+            return -1;
+        }
+    }
+    if (!seen[0] || !seen[1]) {
+        return -1;
+    }
+    rule->birth = masks[0];
+    rule->survive = masks[1];
+    return 0;
+}
+
+unsigned char lifeTransitions[3 << 8];
+
+void lifeInitTransitions(void) {
+    static LifeRule built = {-1, -1};
+    int self, count1, count2;
+    if (built.birth == lifeRule.birth && built.survive == lifeRule.survive) {
+        return;
+    }
+    for (self = DEAD; self <= ALIVE2; self++) {
+        for (count1 = 0; count1 <= 8; count1++) {
+            for (count2 = 0; count1 + count2 <= 8; count2++) {
+                lifeTransitions[LIFE_INDEX(self, count1, count2)] =
+                    lifeNextCell((unsigned char)self, count1, count2, lifeRule.birth, lifeRule.survive);
+            }
+        }
+    }
+    built = lifeRule;
+}
+
+void lifeAdvance(const Engine *engine, void *field, int stepLog) {
+    long long i;
+    if (engine->jump) {
+        engine->jump(field, stepLog);
+        return;
+    }
+    for (i = 0; i < (1LL << stepLog); i++) {
+        engine->step(field);
+    }
+}
+
+uint64_t lifeHash(const Engine *engine, void *field, int width, int height, unsigned char *row) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    int y, x;
+    for (y = 0; y < height; y++) {
+        engine->readRow(field, y, row);
+        for (x = 0; x < width; x++) {
+            h = (h ^ row[x]) * 0x100000001B3ull;
+        }
+    }
+    return h;
+}
+
+uint64_t lifeFieldHash(const Engine *engine, void *field, unsigned char *row) {
+    if (engine->hash) {
+        return engine->hash(field);
+    }
+    return lifeHash(engine, field, lifeOptions.width, lifeOptions.height, row);
+}
+
+int lifeViewWidth(void) {
+    int cells = MAX_WINDOW_SIZE / CELL_SIZE;
+    return lifeOptions.width < cells ? lifeOptions.width : cells;
+}
+
+int lifeViewHeight(void) {
+    int cells = MAX_WINDOW_SIZE / CELL_SIZE;
+    return lifeOptions.height < cells ? lifeOptions.height : cells;
+}
+
+static void usage(const char *argv0) {
+    int i;
+    fprintf(stderr, "Usage: %s [options]\n", argv0);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --width <n>       field width in cells, up to %d (default: %d)\n", MAX_FIELD_SIZE, FIELD_WIDTH);
+    fprintf(stderr, "  --height <n>      field height in cells, up to %d (default: %d)\n", MAX_FIELD_SIZE, FIELD_HEIGHT);
+    fprintf(stderr, "  --engine <name>   stepping engine (default: %s)\n", ENGINE);
+    fprintf(stderr, "  --kernel <name>   vector engine kernel: auto, scalar, branch, lut, sse2, avx2 (default: %s)\n", KERNEL);
+    fprintf(stderr, "  --threads <n>     worker threads for bitplane, vector and plane engines (default: %d)\n", THREADS);
+    fprintf(stderr, "  --step-log <k>    advance 2^k generations per frame (default: %d)\n", STEP_LOG);
+    fprintf(stderr, "  --hashlife-memory <mb>  node cache size before garbage collection (default: %d)\n", HASHLIFE_MEMORY);
+    fprintf(stderr, "  --temporal <k>    vector engine generations per pass over the field, with --step-log (default: %d)\n", TEMPORAL_STEPS);
+    fprintf(stderr, "  --verify          check every step against the dense engine\n");
+    fprintf(stderr, "  --block <w>x<h>   bitplane cache blocks in cells, auto to calibrate or off (default: %s)\n", BLOCK);
+    fprintf(stderr, "  --tile-size <n>   side of the vector engine activity tiles (default: %d)\n", TILE_SIZE);
+    fprintf(stderr, "  --stats           print per-generation statistics\n");
+    fprintf(stderr, "  --generations <n> stop after n generations (default: run until the window is closed)\n");
+    fprintf(stderr, "  --seed <n>        seed of the random initial field (default: current time)\n");
+    fprintf(stderr, "  --load <file>     start from an RLE or .cells pattern instead of a random field\n");
+    fprintf(stderr, "  --save <file>     write the field as RLE or .cells when the run ends\n");
+    fprintf(stderr, "  --checkpoint <file>  save the run to file every --checkpoint-every generations and at the end\n");
+    fprintf(stderr, "  --checkpoint-every <n>  generations between checkpoints (default: %d)\n", CHECKPOINT_EVERY);
+    fprintf(stderr, "  --resume <file>   continue from a checkpoint: field, size, rule, seed and generation\n");
+    fprintf(stderr, "  --cycle <action>  when the field repeats: off, stop, skip to --generations or replay (default: %s)\n", CYCLE);
+    fprintf(stderr, "  --history <mb>    memory for recorded generations to step back through, 0 for none (default: %d)\n", HISTORY_MEMORY);
+    fprintf(stderr, "  --history-every <n>  generations between two records, 0 to keep recording at %d%% of the stepping time (default: %d)\n", HISTORY_OVERHEAD, HISTORY_EVERY);
+    fprintf(stderr, "  --keyframe-every <n>  recorded generations per keyframe, the others are deltas (default: %d)\n", HISTORY_KEYFRAME_EVERY);
+    fprintf(stderr, "  --seek <n>        when the run ends, go back to generation n from the history\n");
+    fprintf(stderr, "  --bench           step without drawing or frame delay, print throughput and field hash\n");
+    fprintf(stderr, "  --rule <B/S>      birth/survival rule, e.g. B36/S23 (default: %s)\n", RULE);
+    fprintf(stderr, "  --gps <n>         target generations per second, 0 for unlimited (default: %d)\n", TARGET_GPS);
+    fprintf(stderr, "  --fps <n>         target frames per second (default: %d)\n", TARGET_FPS);
+    fprintf(stderr, "  --render-thread   step on a separate thread, present the newest generation --fps times a second\n");
+    fprintf(stderr, "Engines:");
+    for (i = 0; i < ENGINE_COUNT; i++) {
+        fprintf(stderr, " %s", engines[i]->name);
+    }
+    fprintf(stderr, "\n");
+    exit(2);
+}
+
+void lifeParseArgs(int argc, char **argv) {
+    int seedSet = 0;
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            lifeOptions.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            lifeOptions.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            lifeOptions.engine = argv[++i];
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            lifeOptions.kernel = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            lifeOptions.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--step-log") == 0 && i + 1 < argc) {
+            lifeOptions.stepLog = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hashlife-memory") == 0 && i + 1 < argc) {
+            lifeOptions.hashlifeMemory = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--temporal") == 0 && i + 1 < argc) {
+            lifeOptions.temporal = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            lifeOptions.verify = 1;
+        } else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc) {
+            lifeOptions.block = argv[++i];
+        } else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc) {
+            lifeOptions.tileSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            lifeOptions.stats = 1;
+        } else if (strcmp(argv[i], "--generations") == 0 && i + 1 < argc) {
+            lifeOptions.generations = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            char *end;
+            lifeOptions.seed = strtoll(argv[++i], &end, 10);
+            if (end == argv[i] || *end) {
+                fprintf(stderr, "Seed must be an integer\n");
+                usage(argv[0]);
+            }
+            seedSet = 1;
+        } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            lifeOptions.load = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            lifeOptions.save = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            lifeOptions.checkpoint = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            lifeOptions.checkpointEvery = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            lifeOptions.resume = argv[++i];
+        } else if (strcmp(argv[i], "--cycle") == 0 && i + 1 < argc) {
+            lifeOptions.cycle = argv[++i];
+        } else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc) {
+            lifeOptions.history = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--history-every") == 0 && i + 1 < argc) {
+            lifeOptions.historyEvery = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--keyframe-every") == 0 && i + 1 < argc) {
+            lifeOptions.keyframeEvery = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            lifeOptions.seek = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            lifeOptions.bench = 1;
+        } else if (strcmp(argv[i], "--rule") == 0 && i + 1 < argc) {
+            lifeOptions.rule = argv[++i];
+        } else if (strcmp(argv[i], "--gps") == 0 && i + 1 < argc) {
+            lifeOptions.gps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            lifeOptions.fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--render-thread") == 0) {
+            lifeOptions.renderThread = 1;
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (lifeOptions.resume) {
+        static CheckpointHeader header;
+        if (checkpointReadHeader(lifeOptions.resume, &header) != 0) {
+            exit(1);
+        }
+        lifeOptions.width = header.width;
+        lifeOptions.height = header.height;
+        lifeOptions.seed = header.seed;
+        lifeOptions.rule = header.rule;
+        seedSet = 1;
+    }
+    if (!seedSet) {
+        lifeOptions.seed = (long long)time(NULL);
+    }
+    if (lifeOptions.resume && lifeOptions.load) {
+        fprintf(stderr, "--load and --resume exclude each other\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.checkpointEvery < 1) {
+        fprintf(stderr, "Checkpoint interval must be positive\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.width < 1 || lifeOptions.width > MAX_FIELD_SIZE ||
+        lifeOptions.height < 1 || lifeOptions.height > MAX_FIELD_SIZE) {
+        fprintf(stderr, "Field size must be in 1..%d\n", MAX_FIELD_SIZE);
+        usage(argv[0]);
+    }
+    if (!lifeFindEngine(lifeOptions.engine)) {
+        fprintf(stderr, "Unknown engine '%s'\n", lifeOptions.engine);
+        usage(argv[0]);
+    }
+    if (strcmp(lifeOptions.engine, "hashlife") == 0 &&
+        ((lifeOptions.width & (lifeOptions.width - 1)) || (lifeOptions.height & (lifeOptions.height - 1)))) {
+        fprintf(stderr, "The hashlife engine needs a power of two field size\n");
+        usage(argv[0]);
+    }
+    if (strcmp(lifeOptions.kernel, "auto") != 0 && strcmp(lifeOptions.kernel, "scalar") != 0 &&
+        strcmp(lifeOptions.kernel, "branch") != 0 && strcmp(lifeOptions.kernel, "lut") != 0 &&
+        strcmp(lifeOptions.kernel, "sse2") != 0 && strcmp(lifeOptions.kernel, "avx2") != 0) {
+        fprintf(stderr, "Unknown kernel '%s'\n", lifeOptions.kernel);
+        usage(argv[0]);
+    }
+    if (lifeOptions.threads < 1) {
+        fprintf(stderr, "Thread count must be positive\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.stepLog < 0 || lifeOptions.stepLog > 62) {
+        fprintf(stderr, "Step log must be in 0..62\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.gps < 0 || lifeOptions.fps < 1 || lifeOptions.fps > 1000) {
+        fprintf(stderr, "Generations per second must not be negative, frames per second must be in 1..1000\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.temporal < 1 || lifeOptions.temporal > 64) {
+        fprintf(stderr, "Temporal steps must be in 1..64\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.verify && strcmp(lifeOptions.engine, "plane") == 0) {
+        fprintf(stderr, "--verify compares against the torus, the plane engine has none\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.hashlifeMemory < 1) {
+        fprintf(stderr, "HashLife memory must be positive\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.generations < 0) {
+        fprintf(stderr, "Generation count must not be negative\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.bench && lifeOptions.generations == 0) {
+        fprintf(stderr, "--bench needs --generations\n");
+        usage(argv[0]);
+    }
+    if (strcmp(lifeOptions.cycle, "off") != 0 && strcmp(lifeOptions.cycle, "stop") != 0 &&
+        strcmp(lifeOptions.cycle, "skip") != 0 && strcmp(lifeOptions.cycle, "replay") != 0) {
+        fprintf(stderr, "Unknown cycle action '%s'\n", lifeOptions.cycle);
+        usage(argv[0]);
+    }
+    if (strcmp(lifeOptions.cycle, "skip") == 0 && lifeOptions.generations == 0) {
+        fprintf(stderr, "--cycle skip needs --generations\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.history < 0 || lifeOptions.historyEvery < 0 || lifeOptions.keyframeEvery < 1) {
+        fprintf(stderr, "History memory and record interval must not be negative, keyframe interval must be positive\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.seek >= 0 && !lifeOptions.history) {
+        fprintf(stderr, "--seek needs --history\n");
+        usage(argv[0]);
+    }
+    int blockWidth, blockHeight;
+    char blockEnd;
+    if (strcmp(lifeOptions.block, "auto") != 0 && strcmp(lifeOptions.block, "off") != 0 &&
+        (sscanf(lifeOptions.block, "%dx%d%c", &blockWidth, &blockHeight, &blockEnd) != 2 ||
+         blockWidth < 1 || blockHeight < 1)) {
+        fprintf(stderr, "Block size must be <width>x<height>, auto or off\n");
+        usage(argv[0]);
+    }
+    if (lifeOptions.tileSize < 1) {
+        fprintf(stderr, "Tile size must be positive\n");
+        usage(argv[0]);
+    }
+    if (lifeParseRule(lifeOptions.rule, &lifeRule) != 0) {
+        fprintf(stderr, "Malformed rule '%s'\n", lifeOptions.rule);
+        usage(argv[0]);
+    }
+    if (lifeRule.birth & 1) {
+        fprintf(stderr, "B0 rules are not supported\n");
+        usage(argv[0]);
+    }
+}
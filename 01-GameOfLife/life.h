@@ -0,0 +1,151 @@
+#ifndef __life__
+#define __life__
+
+#include <stdint.h>
+
+#define DEAD 0
+#define ALIVE1 1
+#define ALIVE2 2
+
+/*
+ * Outer-totalistic rule as bit masks over the neighbor count: bit n of birth is set if a
+ * dead cell with n neighbors is born, bit n of survive if a live one stays alive.
+ */
+typedef struct {
+    int birth;
+    int survive;
+} LifeRule;
+
+/*
+ * Rules the engines carry kernels for with the masks compiled in, as X(name, text, birth, survive).
+ * Any other rule runs on generic kernels that read the masks at run time.
+ */
+#define LIFE_HOT_RULES(X) \
+    X(Life, "B3/S23", 1 << 3, 1 << 2 | 1 << 3) \
+    X(HighLife, "B36/S23", 1 << 3 | 1 << 6, 1 << 2 | 1 << 3) \
+    X(DayNight, "B3678/S34678", 1 << 3 | 1 << 6 | 1 << 7 | 1 << 8, 1 << 3 | 1 << 4 | 1 << 6 | 1 << 7 | 1 << 8) \
+    X(Seeds, "B2/S", 1 << 2, 0)
+
+/* The rule every engine steps with, B3/S23 unless --rule sets another one. */
+extern LifeRule lifeRule;
+
+/* Parses "B3/S23" style rule strings (either order, any case). Returns 0 on success, -1 if malformed. */
+int lifeParseRule(const char *text, LifeRule *rule);
+
+/*
+ * The two-color rule: a newborn cell takes the color of the majority of its parents, ALIVE2 on a tie.
+ * Written without branches so it can sit in inner loops.
+ */
+static inline unsigned char lifeNextCell(unsigned char self, int count1, int count2, int birth, int survive) {
+    int neighbors = count1 + count2;
+    int keep = (survive >> neighbors) & 1;
+    int born = (self == DEAD) & (birth >> neighbors) & 1;
+    return (unsigned char)(keep * self + born * (ALIVE2 - (count1 > count2)));
+}
+
+/*
+ * Next state of every (self, count1, count2) tuple under lifeRule, precomputed from lifeNextCell() by
+ * lifeInitTransitions() so a step is one load instead of compares. The index packs
+ * count1 in bits 0-3, count2 in bits 4-7 and self above them, which is exactly the
+ * byte sum the vector engine accumulates with its 0x01/0x10 neighbor encoding.
+ */
+#define LIFE_INDEX(self, count1, count2) ((self) << 8 | (count2) << 4 | (count1))
+
+extern unsigned char lifeTransitions[3 << 8];
+
+void lifeInitTransitions(void);
+
+/*
+ * Stepping engine. Every engine keeps the field in its own layout and
+ * exchanges cells with app() one row at a time, one byte (DEAD/ALIVE1/ALIVE2) per cell.
+ * Fields created by create() are all DEAD.
+ */
+typedef struct Engine {
+    const char *name;
+    void *(*create)(int width, int height);
+    void (*destroy)(void *field);
+    void (*step)(void *field);
+    void (*readRow)(void *field, int y, unsigned char *row);
+    void (*writeRow)(void *field, int y, const unsigned char *row);
+    /* Advances 2^stepLog generations at once, NULL if the engine can only step() */
+    void (*jump)(void *field, int stepLog);
+    /* Engine specific statistics of the last step for --stats, NULL if there are none */
+    void (*stats)(void *field, char *buf, int size);
+    /*
+     * 64-bit hash of the field kept up to date while stepping, for --cycle. Equal fields hash equal
+     * within one run, hashes of different engines need not agree. NULL if the engine has none,
+     * lifeFieldHash() then hashes through readRow().
+     */
+    uint64_t (*hash)(void *field);
+} Engine;
+
+extern const Engine denseEngine;
+extern const Engine bitplaneEngine;
+extern const Engine vectorEngine;
+extern const Engine hashlifeEngine;
+extern const Engine planeEngine;
+
+const Engine *lifeFindEngine(const char *name);
+
+/* Advances the field by 2^stepLog generations. */
+void lifeAdvance(const Engine *engine, void *field, int stepLog);
+
+/* FNV-1a hash of the cells, the same for every engine holding the same field. */
+uint64_t lifeHash(const Engine *engine, void *field, int width, int height, unsigned char *row);
+
+/* engine->hash() if the engine keeps one, lifeHash() otherwise. */
+uint64_t lifeFieldHash(const Engine *engine, void *field, unsigned char *row);
+
+/* Finalizer of splitmix64, a bijection that spreads every input bit over the whole word. */
+static inline uint64_t lifeMix(uint64_t h) {
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+/* Part of the field shown in the window, in cells. */
+int lifeViewWidth(void);
+int lifeViewHeight(void);
+
+/* Row kernel the vector engine runs with: scalar, branch, lut, sse2 or avx2. */
+const char *vectorKernelName(void);
+
+/*
+ * Run-time options. Defaults come from sim.h, lifeParseArgs() overrides them from the command line.
+ */
+struct LifeOptions {
+    int width;
+    int height;
+    const char *engine;
+    const char *kernel;
+    int threads;
+    int stepLog;
+    int hashlifeMemory;
+    int verify;
+    int tileSize;
+    int stats;
+    long long generations;
+    long long seed;
+    int bench;
+    int renderThread;
+    const char *rule;
+    const char *load;
+    const char *save;
+    const char *checkpoint;
+    long long checkpointEvery;
+    const char *resume;
+    const char *cycle;
+    const char *block;
+    int temporal;
+    int gps;
+    int fps;
+    int history;
+    long long historyEvery;
+    int keyframeEvery;
+    long long seek;
+};
+
+extern struct LifeOptions lifeOptions;
+
+void lifeParseArgs(int argc, char **argv);
+#endif
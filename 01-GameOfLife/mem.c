@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mem.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define HAVE_MMAP 1
+#else
+#define HAVE_MMAP 0
+#endif
+
+#define HUGE_PAGE ((size_t)2 << 20)
+#define MAX_HUGE_BLOCKS 32
+
+static size_t footprint = 0;
+static size_t hugeFootprint = 0;
+/* Blocks mapped with MAP_HUGETLB, so memFree() can tell them apart. */
+static void *hugeBlocks[MAX_HUGE_BLOCKS];
+
+static size_t roundUp(size_t size, size_t to) {
+    return (size + to - 1) / to * to;
+}
+
+static void outOfMemory(size_t size) {
+    fprintf(stderr, "out of memory allocating %zu bytes\n", size);
+    exit(1);
+}
+
+void *memAlloc(size_t size) {
+    void *p;
+
+    if (size == 0) {
+        size = 1;
+    }
+#if HAVE_MMAP
+    if (size >= HUGE_PAGE) {
+        size_t mapped = roundUp(size, HUGE_PAGE);
+#ifdef MAP_HUGETLB
+        int i;
+        for (i = 0; i < MAX_HUGE_BLOCKS && hugeBlocks[i]; i++) {
+        }
+        if (i < MAX_HUGE_BLOCKS) {
+            p = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                hugeBlocks[i] = p;
+                footprint += mapped;
+                hugeFootprint += mapped;
+                return p;
+            }
+        }
+#endif
+        p = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            outOfMemory(size);
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(p, mapped, MADV_HUGEPAGE);
+#endif
+        footprint += mapped;
+        return p;
+    }
+#endif
+    size = roundUp(size, 64);
+    p = aligned_alloc(64, size);
+    if (!p) {
+        outOfMemory(size);
+    }
+    memset(p, 0, size);
+    footprint += size;
+    return p;
+}
+
+void memFree(void *p, size_t size) {
+    if (!p) {
+        return;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+#if HAVE_MMAP
+    if (size >= HUGE_PAGE) {
+        size_t mapped = roundUp(size, HUGE_PAGE);
+        int i;
+        for (i = 0; i < MAX_HUGE_BLOCKS; i++) {
+            if (hugeBlocks[i] == p) {
+                hugeBlocks[i] = NULL;
+                hugeFootprint -= mapped;
+            }
+        }
+        munmap(p, mapped);
+        footprint -= mapped;
+        return;
+    }
+#endif
+    free(p);
+    footprint -= roundUp(size, 64);
+}
+
+size_t memFootprint(void) {
+    return footprint;
+}
+
+size_t memHugeFootprint(void) {
+    return hugeFootprint;
+}
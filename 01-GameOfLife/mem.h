@@ -0,0 +1,18 @@
+#ifndef __mem__
+#define __mem__
+
+#include <stddef.h>
+
+/*
+ * Field storage. Blocks are zeroed and 64-byte aligned.
+ * Blocks of a huge page or more are mapped with MAP_HUGETLB when the system has
+ * huge pages reserved, otherwise they are mapped normally and marked MADV_HUGEPAGE.
+ * Running out of memory is fatal.
+ */
+void *memAlloc(size_t size);
+void memFree(void *p, size_t size);
+
+/* Bytes currently allocated, and how many of them sit on MAP_HUGETLB pages. */
+size_t memFootprint(void);
+size_t memHugeFootprint(void);
+#endif
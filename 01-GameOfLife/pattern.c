@@ -0,0 +1,425 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pattern.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define HAVE_MMAP 1
+#else
+#define HAVE_MMAP 0
+#endif
+
+#define RLE_LINE 70
+
+/* Parse position in the mapped file. */
+typedef struct {
+    const char *path;
+    const char *p;
+    const char *end;
+    int line;
+} Reader;
+
+/* Rows are collected in row and handed to the engine once they are complete. */
+typedef struct {
+    const Engine *engine;
+    void *field;
+    int width;
+    int height;
+    unsigned char *row;
+    int x;
+    int y;
+    int used;
+} Loader;
+
+static int fail(const Reader *r, const char *what) {
+    fprintf(stderr, "%s:%d: %s\n", r->path, r->line, what);
+    return -1;
+}
+
+static int isExtension(const char *path, const char *ext) {
+    size_t n = strlen(path);
+    size_t e = strlen(ext);
+    return n >= e && strcmp(path + n - e, ext) == 0;
+}
+
+static void skipLine(Reader *r) {
+    const char *nl = memchr(r->p, '\n', r->end - r->p);
+    r->p = nl ? nl + 1 : r->end;
+    r->line++;
+}
+
+/* Reads a decimal number, -1 if there is none. Mapped files are not NUL terminated, so no strtol. */
+static long readNumber(Reader *r) {
+    long n = 0;
+    if (r->p == r->end || *r->p < '0' || *r->p > '9') {
+        return -1;
+    }
+    while (r->p < r->end && *r->p >= '0' && *r->p <= '9') {
+        if (n < 1L << 40) {
+            n = n * 10 + (*r->p - '0');
+        }
+        r->p++;
+    }
+    return n;
+}
+
+static void skipBlanks(Reader *r) {
+    while (r->p < r->end && (*r->p == ' ' || *r->p == '\t' || *r->p == '\r')) {
+        r->p++;
+    }
+}
+
+static int put(Loader *l, const Reader *r, long count, unsigned char cell) {
+    if (l->y >= l->height) {
+        return fail(r, "pattern is taller than the field");
+    }
+    if (count > l->width - l->x) {
+        return fail(r, "pattern is wider than the field");
+    }
+    if (cell != DEAD) {
+        memset(l->row + l->x, cell, count);
+        if (l->x + count > l->used) {
+            l->used = l->x + (int)count;
+        }
+    }
+    l->x += (int)count;
+    return 0;
+}
+
+/* Writes the collected row if it has live cells, then moves down count rows. */
+static void endRow(Loader *l, long count) {
+    if (l->used > 0 && l->y < l->height) {
+        l->engine->writeRow(l->field, l->y, l->row);
+        memset(l->row, DEAD, l->used);
+        l->used = 0;
+    }
+    l->x = 0;
+    l->y = count >= l->height - l->y ? l->height : l->y + (int)count;
+}
+
+/* "x = 3, y = 3, rule = B3/S23": checks the size up front and the rule against the one running. */
+static int rleHeader(Reader *r, const Loader *l) {
+    long size[2] = {-1, -1};
+    while (r->p < r->end && *r->p != '\n') {
+        const char *key = r->p;
+        while (r->p < r->end && *r->p >= 'a' && *r->p <= 'z') {
+            r->p++;
+        }
+        int keyLength = (int)(r->p - key);
+        skipBlanks(r);
+        if (keyLength == 0 || r->p == r->end || *r->p != '=') {
+            return fail(r, "malformed header");
+        }
+        r->p++;
+        skipBlanks(r);
+        const char *value = r->p;
+        while (r->p < r->end && *r->p != ',' && *r->p != '\n' && *r->p != '\r' && *r->p != ' ') {
+            r->p++;
+        }
+        if (keyLength == 1 && (*key == 'x' || *key == 'y')) {
+            Reader number = *r;
+            number.p = value;
+            size[*key == 'y'] = readNumber(&number);
+        } else if (keyLength == 4 && memcmp(key, "rule", 4) == 0) {
+            char text[64];
+            LifeRule rule;
+            snprintf(text, sizeof(text), "%.*s", (int)(r->p - value), value);
+            if (lifeParseRule(text, &rule) == 0 &&
+                (rule.birth != lifeRule.birth || rule.survive != lifeRule.survive)) {
+                fprintf(stderr, "%s: pattern rule is %s, running %s\n", r->path, text, lifeOptions.rule);
+            }
+        }
+        skipBlanks(r);
+        if (r->p < r->end && *r->p == ',') {
+            r->p++;
+            skipBlanks(r);
+        }
+    }
+    if (size[0] < 0 || size[1] < 0) {
+        return fail(r, "header without x and y");
+    }
+    if (size[0] > l->width || size[1] > l->height) {
+        char what[128];
+        snprintf(what, sizeof(what), "pattern is %ldx%ld, field is %dx%d", size[0], size[1], l->width, l->height);
+        return fail(r, what);
+    }
+    skipLine(r);
+    return 0;
+}
+
+/* What an RLE byte means. Cell states are their own values. */
+enum { TAG_OTHER = 3, TAG_ROW, TAG_END, TAG_NEWLINE, TAG_BLANK, TAG_DIGIT };
+
+static unsigned char rleTags[256];
+
+static void initRleTags(void) {
+    int c;
+    memset(rleTags, TAG_OTHER, sizeof(rleTags));
+    for (c = '0'; c <= '9'; c++) {
+        rleTags[c] = TAG_DIGIT;
+    }
+    rleTags['b'] = rleTags['.'] = DEAD;
+    rleTags['o'] = rleTags['A'] = ALIVE1;
+    rleTags['B'] = ALIVE2;
+    rleTags['$'] = TAG_ROW;
+    rleTags['!'] = TAG_END;
+    rleTags['\n'] = TAG_NEWLINE;
+    rleTags[' '] = rleTags['\t'] = rleTags['\r'] = TAG_BLANK;
+}
+
+static int loadRle(Reader *r, Loader *l) {
+    while (r->p < r->end && *r->p == '#') {
+        skipLine(r);
+    }
+    if (r->p < r->end && *r->p == 'x' && rleHeader(r, l) != 0) {
+        return -1;
+    }
+    if (!rleTags['!']) {
+        initRleTags();
+    }
+    /* Byte stores into the row may alias anything, so the hot state lives in locals. */
+    const char *p = r->p;
+    const char *end = r->end;
+    unsigned char *row = l->row;
+    int width = l->width;
+    int x = 0;
+    int used = 0;
+    while (p < end) {
+        long count = 1;
+        unsigned char tag = rleTags[(unsigned char)*p++];
+        if (tag == TAG_DIGIT) {
+            count = p[-1] - '0';
+            while (p < end && rleTags[(unsigned char)*p] == TAG_DIGIT) {
+                if (count < 1L << 40) {
+                    count = count * 10 + (*p - '0');
+                }
+                p++;
+            }
+            if (p == end) {
+                r->p = p;
+                return fail(r, "run count at end of file");
+            }
+            tag = rleTags[(unsigned char)*p++];
+        }
+        if (tag <= ALIVE2) {
+            if (l->y >= l->height || count > width - x) {
+                r->p = p;
+                l->x = x;
+                return put(l, r, count, tag);
+            }
+            if (tag != DEAD) {
+                /* Runs are short in soups, keep them out of memset. */
+                long i;
+                for (i = 0; i < count; i++) {
+                    row[x + i] = tag;
+                }
+                used = x + (int)count;
+            }
+            x += (int)count;
+        } else if (tag == TAG_ROW || tag == TAG_END) {
+            l->used = used;
+            endRow(l, tag == TAG_ROW ? count : 1);
+            x = 0;
+            used = 0;
+            if (tag == TAG_END) {
+                return 0;
+            }
+        } else if (tag == TAG_NEWLINE) {
+            r->line++;
+        } else if (tag != TAG_BLANK) {
+            char what[64];
+            r->p = p;
+            snprintf(what, sizeof(what), "unexpected '%c', only states DEAD, ALIVE1 and ALIVE2 are known", p[-1]);
+            return fail(r, what);
+        }
+    }
+    l->used = used;
+    endRow(l, 1);
+    return 0;
+}
+
+static int loadCells(Reader *r, Loader *l) {
+    while (r->p < r->end) {
+        char c = *r->p++;
+        switch (c) {
+        case '!':
+            if (l->x != 0) {
+                return fail(r, "unexpected '!'");
+            }
+            skipLine(r);
+            break;
+        case '.':
+            if (put(l, r, 1, DEAD) != 0) return -1;
+            break;
+        case 'O':
+        case '*':
+            if (put(l, r, 1, ALIVE1) != 0) return -1;
+            break;
+        case 'X':
+            if (put(l, r, 1, ALIVE2) != 0) return -1;
+            break;
+        case '\n':
+            endRow(l, 1);
+            r->line++;
+            break;
+        case '\r':
+            break;
+        default: {
+            char what[32];
+            snprintf(what, sizeof(what), "unexpected '%c'", c);
+            return fail(r, what);
+        }
+        }
+    }
+    endRow(l, 1);
+    return 0;
+}
+
+int patternLoad(const char *path, const Engine *engine, void *field, int width, int height, unsigned char *row) {
+    Reader r = {path, NULL, NULL, 1};
+    Loader l = {engine, field, width, height, row, 0, 0, 0};
+    struct stat st;
+    char *data = NULL;
+    int fd, result;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if (st.st_size > 0) {
+#if HAVE_MMAP
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+#else
+        data = malloc(st.st_size);
+        if (!data || read(fd, data, st.st_size) != st.st_size) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            free(data);
+            close(fd);
+            return -1;
+        }
+#endif
+    }
+    close(fd);
+
+    memset(row, DEAD, width);
+    r.p = data;
+    r.end = data + st.st_size;
+    result = isExtension(path, ".cells") ? loadCells(&r, &l) : loadRle(&r, &l);
+
+    if (data) {
+#if HAVE_MMAP
+        munmap(data, st.st_size);
+#else
+        free(data);
+#endif
+    }
+    return result;
+}
+
+/* RLE output with lines wrapped at RLE_LINE characters. */
+typedef struct {
+    FILE *out;
+    int column;
+} Writer;
+
+static void emit(Writer *w, long count, char tag) {
+    char run[24];
+    int n = count > 1 ? snprintf(run, sizeof(run), "%ld%c", count, tag) : snprintf(run, sizeof(run), "%c", tag);
+    if (w->column + n > RLE_LINE) {
+        fputc('\n', w->out);
+        w->column = 0;
+    }
+    fputs(run, w->out);
+    w->column += n;
+}
+
+static void saveRle(FILE *out, const Engine *engine, void *field, int width, int height, unsigned char *row) {
+    Writer w = {out, 0};
+    const char *tags = "bo";
+    int lastY = 0;
+    int y, x;
+
+    /* Plain two-state letters unless there is an ALIVE2 cell somewhere. */
+    for (y = 0; y < height; y++) {
+        engine->readRow(field, y, row);
+        if (memchr(row, ALIVE2, width)) {
+            tags = ".AB";
+            break;
+        }
+    }
+
+    fprintf(out, "x = %d, y = %d, rule = %s\n", width, height, lifeOptions.rule);
+    for (y = 0; y < height; y++) {
+        engine->readRow(field, y, row);
+        int last = width - 1;
+        while (last >= 0 && row[last] == DEAD) {
+            last--;
+        }
+        if (last < 0) {
+            continue;
+        }
+        if (y > lastY) {
+            emit(&w, y - lastY, '$');
+            lastY = y;
+        }
+        for (x = 0; x <= last;) {
+            int start = x;
+            while (x <= last && row[x] == row[start]) {
+                x++;
+            }
+            emit(&w, x - start, tags[row[start]]);
+        }
+    }
+    emit(&w, 1, '!');
+    fputc('\n', out);
+}
+
+static void saveCells(FILE *out, const Engine *engine, void *field, int width, int height, unsigned char *row) {
+    static const char tags[] = ".OX";
+    int y, x;
+    fprintf(out, "!Name: %dx%d field, rule %s\n", width, height, lifeOptions.rule);
+    for (y = 0; y < height; y++) {
+        engine->readRow(field, y, row);
+        int last = width - 1;
+        while (last >= 0 && row[last] == DEAD) {
+            last--;
+        }
+        for (x = 0; x <= last; x++) {
+            row[x] = tags[row[x]];
+        }
+        fwrite(row, 1, last + 1, out);
+        fputc('\n', out);
+    }
+}
+
+int patternSave(const char *path, const Engine *engine, void *field, int width, int height, unsigned char *row) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+    if (isExtension(path, ".cells")) {
+        saveCells(out, engine, field, width, height, row);
+    } else {
+        saveRle(out, engine, field, width, height, row);
+    }
+    if (fclose(out) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
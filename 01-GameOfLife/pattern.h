@@ -0,0 +1,18 @@
+#ifndef __pattern__
+#define __pattern__
+
+#include "life.h"
+
+/*
+ * Pattern files, picked by extension: .cells is plaintext, anything else is RLE.
+ * The two-color extension follows Golly's multi-state RLE: '.' or 'b' is DEAD,
+ * 'A' or 'o' ALIVE1 and 'B' ALIVE2. Plaintext uses '.', 'O' and 'X' for ALIVE2.
+ *
+ * patternLoad() maps the file and parses it in one pass, writing each finished row
+ * into the field as it goes, top-left corner of the pattern at cell (0, 0).
+ * The field must be all DEAD. row is a scratch row of the field width.
+ * Both functions print what went wrong and return -1 on failure, 0 on success.
+ */
+int patternLoad(const char *path, const Engine *engine, void *field, int width, int height, unsigned char *row);
+int patternSave(const char *path, const Engine *engine, void *field, int width, int height, unsigned char *row);
+#endif
@@ -0,0 +1,122 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "pool.h"
+
+static pthread_t *workers = NULL;
+static int threadCount = 1;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+static unsigned long generation = 0;
+static unsigned long startGeneration = 0;
+static int pending = 0;
+static int stopping = 0;
+
+static __thread int threadIndex = 0;
+
+static BandFn job;
+static void *jobCtx;
+static int jobRows;
+
+static void runBand(int index) {
+    int y0 = (int)((long long)jobRows * index / threadCount);
+    int y1 = (int)((long long)jobRows * (index + 1) / threadCount);
+    if (y0 < y1) {
+        job(jobCtx, y0, y1);
+    }
+}
+
+static void *worker(void *arg) {
+    int index = (int)(intptr_t)arg;
+    unsigned long seen = startGeneration;
+    threadIndex = index;
+
+    pthread_mutex_lock(&lock);
+    while (1) {
+        while (generation == seen && !stopping) {
+            pthread_cond_wait(&wake, &lock);
+        }
+        if (stopping) {
+            break;
+        }
+        seen = generation;
+        pthread_mutex_unlock(&lock);
+
+        runBand(index);
+
+        pthread_mutex_lock(&lock);
+        if (--pending == 0) {
+            pthread_cond_signal(&done);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+void poolStart(int threads) {
+    int i;
+    if (threads < 1) {
+        threads = 1;
+    }
+    threadCount = threads;
+    stopping = 0;
+    if (threads == 1) {
+        return;
+    }
+    startGeneration = generation;
+    workers = malloc(sizeof(pthread_t) * threads);
+    for (i = 1; i < threads; i++) {
+        pthread_create(&workers[i], NULL, worker, (void *)(intptr_t)i);
+    }
+}
+
+void poolStop(void) {
+    int i;
+    if (!workers) {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    stopping = 1;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&lock);
+    for (i = 1; i < threadCount; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    workers = NULL;
+    threadCount = 1;
+}
+
+int poolThreads(void) {
+    return threadCount;
+}
+
+int poolIndex(void) {
+    return threadIndex;
+}
+
+void poolRun(BandFn fn, void *ctx, int rows) {
+    if (threadCount == 1) {
+        fn(ctx, 0, rows);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    job = fn;
+    jobCtx = ctx;
+    jobRows = rows;
+    pending = threadCount - 1;
+    generation++;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&lock);
+
+    runBand(0);
+
+    pthread_mutex_lock(&lock);
+    while (pending > 0) {
+        pthread_cond_wait(&done, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
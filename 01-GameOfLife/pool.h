@@ -0,0 +1,18 @@
+#ifndef __pool__
+#define __pool__
+
+/*
+ * Persistent worker pool for row-band parallel stepping.
+ * poolRun() splits rows 0..rows-1 into one contiguous band per thread,
+ * runs band 0 on the calling thread and returns once every band is done.
+ * Threads are created once by poolStart(), never per generation.
+ */
+typedef void (*BandFn)(void *ctx, int y0, int y1);
+
+void poolStart(int threads);
+void poolStop(void);
+int poolThreads(void);
+/* Index of the pool thread running the calling band, 0 on the caller: bands running at once have distinct ones. */
+int poolIndex(void);
+void poolRun(BandFn fn, void *ctx, int rows);
+#endif
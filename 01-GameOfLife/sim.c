@@ -1,30 +1,51 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <SDL2/SDL.h>
-#include <time.h>
 #include "sim.h"
+#include "life.h"
 
-#define SIM_Y_SIZE (FIELD_HEIGHT * CELL_SIZE)
-#define SIM_X_SIZE (FIELD_WIDTH * CELL_SIZE)
+#define SIM_Y_SIZE (lifeViewHeight() * CELL_SIZE)
+#define SIM_X_SIZE (lifeViewWidth() * CELL_SIZE)
 
+/*
+ * Drawing goes into a CPU-side framebuffer with one ARGB pixel per cell.
+ * simFlush() uploads it into a streaming texture and lets the renderer
+ * scale it by CELL_SIZE in a single copy, so the cost of a frame no longer
+ * depends on how many rectangles were drawn.
+ */
 static SDL_Renderer *Renderer = NULL;
 static SDL_Window *Window = NULL;
+static SDL_Texture *Texture = NULL;
+static Uint32 *Frame = NULL;
+static int FrameWidth = 0;
+static int FrameHeight = 0;
+/* Set once simWaitEvent() has taken the quit event off the queue, where checkFinish() would look for it. */
+static int QuitRequested = 0;
 
 void simInit() {
     SDL_Init(SDL_INIT_VIDEO);
     SDL_CreateWindowAndRenderer(SIM_X_SIZE, SIM_Y_SIZE, 0, &Window, &Renderer);
-    SDL_SetRenderDrawColor(Renderer, 0, 0, 0, 0);
-    SDL_RenderClear(Renderer);
-    srand(time(NULL));
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    FrameWidth = lifeViewWidth();
+    FrameHeight = lifeViewHeight();
+    Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                FrameWidth, FrameHeight);
+    Frame = malloc(sizeof(Uint32) * FrameWidth * FrameHeight);
+    for (int i = 0; i < FrameWidth * FrameHeight; i++) {
+        Frame[i] = 0xFF000000;
+    }
+    srand((unsigned)lifeOptions.seed);
     simFlush();
 }
 
 void simExit() {
     SDL_Event event;
-    while (1) {
-        if (SDL_PollEvent(&event) && event.type == SDL_QUIT)
+    while (!QuitRequested && SDL_WaitEvent(&event)) {
+        if (event.type == SDL_QUIT)
             break;
     }
+    free(Frame);
+    SDL_DestroyTexture(Texture);
     SDL_DestroyRenderer(Renderer);
     SDL_DestroyWindow(Window);
     SDL_Quit();
@@ -32,28 +53,42 @@ void simExit() {
 
 void simFlush() {
     SDL_PumpEvents();
+    SDL_UpdateTexture(Texture, NULL, Frame, FrameWidth * sizeof(Uint32));
+    SDL_RenderCopy(Renderer, Texture, NULL, NULL);
     SDL_RenderPresent(Renderer);
 }
 
+/* Pixels are kept per cell: a pixel colors the whole cell it falls into. */
 void simPutPixel(int x, int y, int rgb) {
     assert(0 <= x && x < SIM_X_SIZE);
     assert(0 <= y && y < SIM_Y_SIZE);
-    Uint8 r = (rgb >> 16) & 0xFF;
-    Uint8 g = (rgb >> 8) & 0xFF;
-    Uint8 b = rgb & 0xFF;
-    SDL_SetRenderDrawColor(Renderer, r, g, b, 255);
-    SDL_RenderDrawPoint(Renderer, x, y);
+    Frame[(y / CELL_SIZE) * FrameWidth + x / CELL_SIZE] = 0xFF000000 | (Uint32)rgb;
 }
 
-void simFillRect(int x, int y, int w, int h, int rgb) {
+static void fillFrame(int x, int y, int w, int h, Uint32 color) {
     assert(0 <= x && x + w <= SIM_X_SIZE);
     assert(0 <= y && y + h <= SIM_Y_SIZE);
-    Uint8 r = (rgb >> 16) & 0xFF;
-    Uint8 g = (rgb >> 8) & 0xFF;
-    Uint8 b = rgb & 0xFF;
-    SDL_SetRenderDrawColor(Renderer, r, g, b, 255);
-    SDL_Rect rect = {x, y, w, h};
-    SDL_RenderFillRect(Renderer, &rect);
+    int x0 = x / CELL_SIZE;
+    int x1 = (x + w + CELL_SIZE - 1) / CELL_SIZE;
+    int y0 = y / CELL_SIZE;
+    int y1 = (y + h + CELL_SIZE - 1) / CELL_SIZE;
+    for (int cy = y0; cy < y1; cy++) {
+        Uint32 *row = Frame + cy * FrameWidth;
+        for (int cx = x0; cx < x1; cx++) {
+            row[cx] = color;
+        }
+    }
+}
+
+void simFillRect(int x, int y, int w, int h, int rgb) {
+    fillFrame(x, y, w, h, 0xFF000000 | (Uint32)rgb);
+}
+
+void simFillRects(const SimRect *rects, int count, int rgb) {
+    Uint32 color = 0xFF000000 | (Uint32)rgb;
+    for (int i = 0; i < count; i++) {
+        fillFrame(rects[i].x, rects[i].y, rects[i].w, rects[i].h, color);
+    }
 }
 
 int simRand() {
@@ -69,11 +104,47 @@ void simDelay(int ms) {
 }
 
 int checkFinish() {
-    if (SDL_HasEvent(SDL_QUIT) != SDL_TRUE)
+    if (!QuitRequested && SDL_HasEvent(SDL_QUIT) != SDL_TRUE)
         return 0;
     return 1;
 }
 
+int simWaitEvent(SimEvent *event, int timeoutMs) {
+    SDL_Event e;
+    int start = SDL_GetTicks();
+    int left = timeoutMs;
+    while (left >= 0 && SDL_WaitEventTimeout(&e, left)) {
+        switch (e.type) {
+        case SDL_QUIT:
+            QuitRequested = 1;
+            event->type = SIM_EVENT_QUIT;
+            return 1;
+        case SDL_MOUSEBUTTONDOWN:
+            event->type = SIM_EVENT_MOUSE;
+            event->x = e.button.x;
+            event->y = e.button.y;
+            event->buttons = SDL_BUTTON(e.button.button);
+            return 1;
+        case SDL_MOUSEMOTION:
+            if (!e.motion.state)
+                break;
+            event->type = SIM_EVENT_MOUSE;
+            event->x = e.motion.x;
+            event->y = e.motion.y;
+            event->buttons = e.motion.state;
+            return 1;
+        case SDL_KEYDOWN:
+            event->type = SIM_EVENT_KEY;
+            event->key = e.key.keysym.scancode;
+            return 1;
+        }
+        /* Events the caller does not see do not restart the wait. */
+        left = timeoutMs - (int)(SDL_GetTicks() - start);
+    }
+    event->type = SIM_EVENT_NONE;
+    return 0;
+}
+
 int simGetMouseX() {
     int x, y;
     SDL_GetMouseState(&x, &y);
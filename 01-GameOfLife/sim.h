@@ -2,9 +2,17 @@
  * Width and height of the field are set in cells.
  * Changing these values will change the size of the field in cells.
  * The actual size of the simulation window will be CELL_SIZE times larger.
+ * These are defaults, --width and --height set the size at startup, up to MAX_FIELD_SIZE.
  */
 #define FIELD_WIDTH 64
 #define FIELD_HEIGHT 64
+#define MAX_FIELD_SIZE 65536
+
+/*
+ * Largest side of the simulation window in pixels.
+ * Fields that do not fit show their top-left corner.
+ */
+#define MAX_WINDOW_SIZE 1024
 
 /*
  * Size of a cell in pixels. Changing this value will change the size of the simulation window.
@@ -15,9 +23,11 @@
 /*
  * If EDITOR_MODE is set to 1, the simulation starts in editing mode,
  * allowing you to set the initial state of the field using the mouse.
- * Press space to start the simulation.
+ * Press space to start the simulation. The editor sleeps until there is input and redraws
+ * only the cells it changes; EDITOR_WAIT_MS bounds a single wait.
  */
 #define EDITOR_MODE 0
+#define EDITOR_WAIT_MS 500
 
 /*
  * If RANDOM_INIT is set to 1, the field is initialized with a random distribution of alive cells.
@@ -25,15 +35,120 @@
 #define RANDOM_INIT 1
 
 /*
- * Time in milliseconds between generations. Lower values make the simulation run faster.
+ * Pacing of the window: TARGET_GPS generations per second (--gps, 0 for as fast as the engine goes)
+ * and TARGET_FPS presented frames per second (--fps). Generations are batched between two frames;
+ * a frame that comes due while the simulation is behind its target is skipped, at most
+ * MAX_SKIPPED_FRAMES in a row so the window keeps showing progress on hosts that can never catch up.
  */
-#define MS_PER_GENERATION 10
+#define TARGET_GPS 100
+#define TARGET_FPS 60
+#define MAX_SKIPPED_FRAMES 8
 
 /*
  * Probability (in percent) of a cell being alive at the start if RANDOM_INIT is enabled.
+ * Cell (x, y) is drawn from number y * width + x of the --seed stream of simRandomAt(),
+ * so a seed gives the same field whatever the thread count.
  */
 #define ALIVE_PROB 30
 
+/*
+ * Stepping engine used unless another one is given with --engine.
+ * dense - one int per cell, the reference implementation.
+ * bitplane - two bit-packed planes (ALIVE1/ALIVE2), 64 cells per machine word.
+ * vector - one byte per cell in a grid with a one-cell halo, rows are stepped with SSE2/AVX2 kernels.
+ * hashlife - memoized quadtree, needs a power-of-two field width and height.
+ * plane - unbounded plane of 64x64 chunks in a hash map, only chunks near live cells exist;
+ *         the field size is the part of the plane that is shown, loaded and saved.
+ */
+#define ENGINE "dense"
+
+/*
+ * Row kernel of the vector engine: scalar, branch, lut, sse2, avx2 or auto.
+ * auto picks the widest instruction set the CPU reports through cpuid.
+ * lut looks the next state up in a table indexed by the packed neighbor counts,
+ * branch is the rule written as nested ifs, the baseline for both.
+ * All kernels produce identical fields.
+ */
+#define KERNEL "auto"
+
+/*
+ * Number of threads stepping the field (bitplane, vector and plane engines).
+ * The field is split into horizontal bands, one per thread. Drawing always stays on the main thread.
+ */
+#define THREADS 1
+
+/*
+ * Each frame advances the field by 2^STEP_LOG generations.
+ * The hashlife engine jumps there in one step, the other engines repeat single steps.
+ */
+#define STEP_LOG 0
+
+/*
+ * Memory in megabytes the hashlife node cache may use before it is garbage collected.
+ */
+#define HASHLIFE_MEMORY 256
+
+/*
+ * Cache blocks the bitplane engine steps the field in, as "<width>x<height>" in cells (width is rounded up
+ * to 64), "off" for whole rows, or "auto" to time a set of sizes on the field when it is created and
+ * keep the fastest. Blocks matter once three rows of the field no longer fit into the L1 cache.
+ */
+#define BLOCK "auto"
+
+/*
+ * Generations the vector engine advances per pass over the field when a frame step covers several
+ * (STEP_LOG above 0). Each pass reads and writes the field once, at the price of recomputing a
+ * border of TEMPORAL_STEPS cells around every tile. 1 steps one generation per pass.
+ */
+#define TEMPORAL_STEPS 1
+
+/*
+ * Side of the square tiles the vector engine tracks activity in.
+ * Tiles where nothing changed in the last generation, and nothing changed around them, are not recomputed.
+ */
+#define TILE_SIZE 32
+
+/*
+ * Birth/survival rule in B/S notation, e.g. B36/S23 for HighLife or B2/S for Seeds.
+ * B3/S23, B36/S23, B3678/S34678 and B2/S have kernels with the rule compiled in, other rules
+ * run on kernels that look it up at run time. Rules where empty cells are born (B0) are not supported.
+ */
+#define RULE "B3/S23"
+
+/*
+ * Generations between two checkpoints written with --checkpoint.
+ */
+#define CHECKPOINT_EVERY 10000
+
+/*
+ * What to do once the field repeats itself, as a still life or an oscillator:
+ * "off" keeps stepping, "stop" ends the run, "skip" jumps ahead to --generations and
+ * "replay" keeps showing the recorded cycle without stepping. Periods up to CYCLE_HISTORY
+ * frame steps are found, each confirmed over one full repetition before acting on it.
+ */
+#define CYCLE "off"
+#define CYCLE_HISTORY 64
+
+/*
+ * Memory in MiB kept for stepping back through the run (--history, 0 for none). The field is recorded as a
+ * delta to the record before, every HISTORY_KEYFRAME_EVERY-th record (--keyframe-every) as a keyframe; the
+ * oldest keyframes and their deltas make room for new ones. Records are HISTORY_EVERY generations apart
+ * (--history-every), with 0 far enough apart that recording takes HISTORY_OVERHEAD percent of the stepping
+ * time. Generations between two records are stepped again when sought. In the window the left and right arrow keys
+ * move through the history a frame step at a time while held, stepping goes on from the shown one when released.
+ */
+#define HISTORY_MEMORY 0
+#define HISTORY_EVERY 0
+#define HISTORY_OVERHEAD 2
+#define HISTORY_KEYFRAME_EVERY 64
+
+/*
+ * If RENDER_THREAD is set to 1 (or --render-thread is given), generations are computed on their own thread
+ * at TARGET_GPS (without any delay with --gps 0) and handed to the window through a triple buffer. The window
+ * shows the newest one TARGET_FPS times a second, generations computed in between are dropped from display.
+ */
+#define RENDER_THREAD 0
+
 
 #define ALIVE_COLOR1 0xC71585
 #define ALIVE_COLOR2 0x00FF00
@@ -41,13 +156,45 @@
 
 #ifndef __sim__
 #define __sim__
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} SimRect;
+
 void simInit();
 void app();
 void simExit();
 void simFlush();
 void simPutPixel(int x, int y, int rgb);
 void simFillRect(int x, int y, int w, int h, int rgb);
+/* Fills count rectangles with one color, callers group their rectangles by color. */
+void simFillRects(const SimRect *rects, int count, int rgb);
 int simRand();
+
+/*
+ * Counter-based random numbers: number counter of the stream seed is the SplitMix64 finalizer
+ * of seed and counter, with no state in between. Any part of a stream can be drawn on its own,
+ * in any order, by any thread or vector lane, and always comes out the same.
+ */
+static inline uint64_t simRandomAt(uint64_t seed, uint64_t counter) {
+    uint64_t z = seed * 0xD1B54A32D192ED03ull + (counter + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Numbers counter..counter+n-1 of the stream seed. The loop has no carried state, so it vectorizes. */
+static inline void simRandomFill(uint64_t seed, uint64_t counter, uint64_t *out, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) {
+        out[i] = simRandomAt(seed, counter + i);
+    }
+}
 int simGetTicks();
 void simDelay(int ms);
 int checkFinish();
@@ -55,4 +202,22 @@ int simGetMouseX();
 int simGetMouseY();
 int simIsMouseButtonDown(int button);
 int simIsKeyDown(int scancode);
+
+enum { SIM_EVENT_NONE, SIM_EVENT_QUIT, SIM_EVENT_MOUSE, SIM_EVENT_KEY };
+
+/*
+ * Input for event-driven loops. SIM_EVENT_MOUSE is a button press, or a move with a button held:
+ * x and y are in window pixels, bit n-1 of buttons is set for every mouse button n held down.
+ * SIM_EVENT_KEY is a key press with its scancode in key.
+ */
+typedef struct {
+    int type;
+    int x;
+    int y;
+    int buttons;
+    int key;
+} SimEvent;
+
+/* Sleeps until there is input or timeoutMs have passed. Returns 0 with SIM_EVENT_NONE on timeout. */
+int simWaitEvent(SimEvent *event, int timeoutMs);
 #endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <time.h>
+#include "sim.h"
+#include "life.h"
+
+/*
+ * No-op backend for benchmarks and machines without a display.
+ * Link it instead of sim.c: nothing is drawn, and the simulation runs
+ * until --generations is reached. simDelay() still sleeps, so runs keep to
+ * --gps and --fps; --gps 0 or --bench run as fast as the engine goes.
+ */
+
+/* simGetTicks() counts from simInit() (or its first call), so the int lasts 24 days of the run rather than of uptime. */
+static long long startMs = -1;
+
+static long long monotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void simInit() {
+    srand((unsigned)lifeOptions.seed);
+    startMs = monotonicMs();
+}
+
+void simExit() {
+}
+
+void simFlush() {
+}
+
+void simPutPixel(int x, int y, int rgb) {
+    (void)x;
+    (void)y;
+    (void)rgb;
+}
+
+void simFillRect(int x, int y, int w, int h, int rgb) {
+    (void)x;
+    (void)y;
+    (void)w;
+    (void)h;
+    (void)rgb;
+}
+
+void simFillRects(const SimRect *rects, int count, int rgb) {
+    (void)rects;
+    (void)count;
+    (void)rgb;
+}
+
+int simRand() {
+    return rand();
+}
+
+int simGetTicks() {
+    if (startMs < 0) {
+        startMs = monotonicMs();
+    }
+    return (int)(monotonicMs() - startMs);
+}
+
+void simDelay(int ms) {
+    struct timespec ts;
+    if (ms <= 0) {
+        return;
+    }
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000;
+    nanosleep(&ts, NULL);
+}
+
+int checkFinish() {
+    return 0;
+}
+
+int simGetMouseX() {
+    return 0;
+}
+
+int simGetMouseY() {
+    return 0;
+}
+
+int simIsMouseButtonDown(int button) {
+    (void)button;
+    return 0;
+}
+
+int simIsKeyDown(int scancode) {
+    (void)scancode;
+    return 0;
+}
+
+/* There is no input, so an editor waiting for it is told to finish right away. */
+int simWaitEvent(SimEvent *event, int timeoutMs) {
+    (void)timeoutMs;
+    event->type = SIM_EVENT_QUIT;
+    return 1;
+}
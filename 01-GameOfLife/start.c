@@ -1,6 +1,8 @@
 #include "sim.h"
+#include "life.h"
 
-int main(void) {
+int main(int argc, char **argv) {
+    lifeParseArgs(argc, argv);
     simInit();
     app();
     simExit();
@@ -0,0 +1,52 @@
+#include "triple.h"
+#include "mem.h"
+
+/* middle holds the index of the shared slot, FRESH is set while it holds a frame the reader has not taken. */
+#define FRESH 4
+
+void tripleInit(TripleBuffer *t, size_t size) {
+    int i;
+    for (i = 0; i < 3; i++) {
+        t->slots[i] = memAlloc(size);
+        t->generation[i] = 0;
+    }
+    t->size = size;
+    t->back = 0;
+    t->front = 2;
+    atomic_init(&t->middle, 1);
+    atomic_init(&t->presented, 0);
+    atomic_init(&t->dropped, 0);
+}
+
+void tripleFree(TripleBuffer *t) {
+    int i;
+    for (i = 0; i < 3; i++) {
+        memFree(t->slots[i], t->size);
+    }
+}
+
+unsigned char *tripleBack(TripleBuffer *t) {
+    return t->slots[t->back];
+}
+
+void triplePublish(TripleBuffer *t, long long generation) {
+    t->generation[t->back] = generation;
+    int old = atomic_exchange_explicit(&t->middle, t->back | FRESH, memory_order_acq_rel);
+    if (old & FRESH) {
+        atomic_fetch_add_explicit(&t->dropped, 1, memory_order_relaxed);
+    }
+    t->back = old & ~FRESH;
+}
+
+const unsigned char *tripleAcquire(TripleBuffer *t, long long *generation) {
+    if (!(atomic_load_explicit(&t->middle, memory_order_relaxed) & FRESH)) {
+        return NULL;
+    }
+    int old = atomic_exchange_explicit(&t->middle, t->front, memory_order_acq_rel);
+    t->front = old & ~FRESH;
+    atomic_fetch_add_explicit(&t->presented, 1, memory_order_relaxed);
+    if (generation) {
+        *generation = t->generation[t->front];
+    }
+    return t->slots[t->front];
+}
@@ -0,0 +1,33 @@
+#ifndef __triple__
+#define __triple__
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/*
+ * Lock-free triple buffer handing frames from one writer thread to one reader thread.
+ * The writer fills tripleBack() and publishes it, the reader takes the newest
+ * published frame. Neither side ever waits for the other: a frame published
+ * before the previous one was taken replaces it and is counted as dropped.
+ */
+typedef struct {
+    unsigned char *slots[3];
+    long long generation[3];
+    size_t size;
+    int back;
+    int front;
+    _Alignas(64) atomic_int middle;
+    atomic_llong presented;
+    atomic_llong dropped;
+} TripleBuffer;
+
+void tripleInit(TripleBuffer *t, size_t size);
+void tripleFree(TripleBuffer *t);
+
+/* Writer side: the slot to fill, then publish it as the frame of the given generation. */
+unsigned char *tripleBack(TripleBuffer *t);
+void triplePublish(TripleBuffer *t, long long generation);
+
+/* Reader side: the newest frame if one was published since the last call, NULL otherwise. */
+const unsigned char *tripleAcquire(TripleBuffer *t, long long *generation);
+#endif
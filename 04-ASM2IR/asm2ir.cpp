@@ -167,22 +167,50 @@ void generateIR(const std::vector<std::unique_ptr<ASM::Instruction>>& program, c
         module, regsType, false, llvm::GlobalValue::CommonLinkage,
         llvm::ConstantAggregateZero::get(regsType), "regs");
     
+    // Два буфера поля и указатели current/next на них, swap_buffers меняет указатели местами
     llvm::ArrayType* fieldType = llvm::ArrayType::get(llvm::ArrayType::get(i32Type, 64), 64);
+    llvm::ArrayType* buffersType = llvm::ArrayType::get(fieldType, 2);
+    llvm::PointerType* fieldPtrType = llvm::PointerType::getUnqual(fieldType);
+    llvm::GlobalVariable* buffers = new llvm::GlobalVariable(
+        module, buffersType, false, llvm::GlobalValue::CommonLinkage,
+        llvm::ConstantAggregateZero::get(buffersType), "buffers");
+    
+    auto bufferAddr = [&](int index) {
+        llvm::Constant* indices[] = {
+            llvm::ConstantInt::get(i32Type, 0),
+            llvm::ConstantInt::get(i32Type, index)
+        };
+        return llvm::ConstantExpr::getInBoundsGetElementPtr(buffersType, buffers, indices);
+    };
+    
     llvm::GlobalVariable* current = new llvm::GlobalVariable(
-        module, fieldType, false, llvm::GlobalValue::CommonLinkage,
-        llvm::ConstantAggregateZero::get(fieldType), "current");
+        module, fieldPtrType, false, llvm::GlobalValue::InternalLinkage,
+        bufferAddr(0), "current");
     
     llvm::GlobalVariable* next = new llvm::GlobalVariable(
-        module, fieldType, false, llvm::GlobalValue::CommonLinkage,
-        llvm::ConstantAggregateZero::get(fieldType), "next");
+        module, fieldPtrType, false, llvm::GlobalValue::InternalLinkage,
+        bufferAddr(1), "next");
     
     llvm::GlobalVariable* temp = new llvm::GlobalVariable(
         module, i32Type, false, llvm::GlobalValue::CommonLinkage,
         llvm::ConstantInt::get(i32Type, 0), "temp");
     
     // Внешние функции
-    llvm::FunctionType* fillRectType = llvm::FunctionType::get(voidType, {i32Type, i32Type, i32Type, i32Type, i32Type}, false);
-    llvm::FunctionCallee fillRectFunc = module.getOrInsertFunction("simFillRect", fillRectType);
+    // Пакеты прямоугольников для draw_field: по одному на цвет клетки (DEAD, ALIVE1, ALIVE2)
+    llvm::ArrayType* rectType = llvm::ArrayType::get(i32Type, 4);
+    llvm::ArrayType* batchType = llvm::ArrayType::get(rectType, 64 * 64);
+    llvm::ArrayType* batchesType = llvm::ArrayType::get(batchType, 3);
+    llvm::ArrayType* countsType = llvm::ArrayType::get(i32Type, 3);
+    llvm::GlobalVariable* rectBatches = new llvm::GlobalVariable(
+        module, batchesType, false, llvm::GlobalValue::InternalLinkage,
+        llvm::ConstantAggregateZero::get(batchesType), "rect_batches");
+    llvm::GlobalVariable* rectCounts = new llvm::GlobalVariable(
+        module, countsType, false, llvm::GlobalValue::InternalLinkage,
+        llvm::ConstantAggregateZero::get(countsType), "rect_counts");
+    
+    llvm::FunctionType* fillRectsType = llvm::FunctionType::get(voidType,
+        {llvm::PointerType::getUnqual(rectType), i32Type, i32Type}, false);
+    llvm::FunctionCallee fillRectsFunc = module.getOrInsertFunction("simFillRects", fillRectsType);
     
     llvm::FunctionType* flushType = llvm::FunctionType::get(voidType, false);
     llvm::FunctionCallee flushFunc = module.getOrInsertFunction("simFlush", flushType);
@@ -219,7 +247,8 @@ void generateIR(const std::vector<std::unique_ptr<ASM::Instruction>>& program, c
             y,
             x
         };
-        return builder.CreateGEP(fieldType, field, indices);
+        llvm::Value* base = builder.CreateLoad(fieldPtrType, field);
+        return builder.CreateGEP(fieldType, base, indices);
     };
     
     // Начинаем генерацию кода
@@ -293,6 +322,14 @@ void generateIR(const std::vector<std::unique_ptr<ASM::Instruction>>& program, c
                 llvm::BasicBlock* xLoopBody = llvm::BasicBlock::Create(context, "draw_x_body", mainFunc);
                 llvm::BasicBlock* xLoopEnd = llvm::BasicBlock::Create(context, "draw_x_end", mainFunc);
                 
+                auto getCountPtr = [&](llvm::Value* cell) {
+                    llvm::Value* indices[] = {llvm::ConstantInt::get(i32Type, 0), cell};
+                    return builder.CreateGEP(countsType, rectCounts, indices);
+                };
+                for (int c = 0; c < 3; c++) {
+                    builder.CreateStore(llvm::ConstantInt::get(i32Type, 0), getCountPtr(llvm::ConstantInt::get(i32Type, c)));
+                }
+                
                 // Внешний цикл по y
                 llvm::Value* yPtr = getRegPtr(0); // Используем x0 как счетчик
                 builder.CreateStore(llvm::ConstantInt::get(i32Type, 0), yPtr);
@@ -322,27 +359,29 @@ void generateIR(const std::vector<std::unique_ptr<ASM::Instruction>>& program, c
                 llvm::Value* cellPtr = getFieldPtr(current, y, x);
                 llvm::Value* cellVal = builder.CreateLoad(i32Type, cellPtr);
                 
-                // Вычисляем цвет
+                // Номер пакета по состоянию клетки
                 llvm::Value* isAlive1 = builder.CreateICmpEQ(cellVal, llvm::ConstantInt::get(i32Type, 1));
                 llvm::Value* isAlive2 = builder.CreateICmpEQ(cellVal, llvm::ConstantInt::get(i32Type, 2));
-                
-                llvm::Value* color1 = llvm::ConstantInt::get(i32Type, 0xC71585);
-                llvm::Value* color2 = llvm::ConstantInt::get(i32Type, 0x00FF00);
-                llvm::Value* colorDead = llvm::ConstantInt::get(i32Type, 0x000000);
-                
-                llvm::Value* color = builder.CreateSelect(isAlive1, color1, 
-                                    builder.CreateSelect(isAlive2, color2, colorDead));
+                llvm::Value* cell = builder.CreateSelect(isAlive1, llvm::ConstantInt::get(i32Type, 1),
+                                    builder.CreateSelect(isAlive2, llvm::ConstantInt::get(i32Type, 2),
+                                                         llvm::ConstantInt::get(i32Type, 0)));
                 
                 // Вычисляем координаты
                 llvm::Value* xCoord = builder.CreateMul(x, llvm::ConstantInt::get(i32Type, 4));
                 llvm::Value* yCoord = builder.CreateMul(y, llvm::ConstantInt::get(i32Type, 4));
                 
-                // Вызываем simFillRect
-                llvm::Value* args[] = {xCoord, yCoord, 
-                                      llvm::ConstantInt::get(i32Type, 4),
-                                      llvm::ConstantInt::get(i32Type, 4),
-                                      color};
-                builder.CreateCall(fillRectFunc, args);
+                // Добавляем прямоугольник в пакет
+                llvm::Value* countPtr = getCountPtr(cell);
+                llvm::Value* count = builder.CreateLoad(i32Type, countPtr);
+                llvm::Value* fields[] = {xCoord, yCoord,
+                                        llvm::ConstantInt::get(i32Type, 4),
+                                        llvm::ConstantInt::get(i32Type, 4)};
+                for (int f = 0; f < 4; f++) {
+                    llvm::Value* indices[] = {llvm::ConstantInt::get(i32Type, 0), cell, count,
+                                              llvm::ConstantInt::get(i32Type, f)};
+                    builder.CreateStore(fields[f], builder.CreateGEP(batchesType, rectBatches, indices));
+                }
+                builder.CreateStore(builder.CreateAdd(count, llvm::ConstantInt::get(i32Type, 1)), countPtr);
                 
                 // Инкремент x
                 llvm::Value* xInc = builder.CreateAdd(x, llvm::ConstantInt::get(i32Type, 1));
@@ -359,6 +398,18 @@ void generateIR(const std::vector<std::unique_ptr<ASM::Instruction>>& program, c
                 
                 // Конец внешнего цикла
                 builder.SetInsertPoint(yLoopEnd);
+                
+                // Один вызов simFillRects на цвет
+                const int colors[3] = {0x000000, 0xC71585, 0x00FF00};
+                for (int c = 0; c < 3; c++) {
+                    llvm::Value* indices[] = {llvm::ConstantInt::get(i32Type, 0),
+                                              llvm::ConstantInt::get(i32Type, c),
+                                              llvm::ConstantInt::get(i32Type, 0)};
+                    llvm::Value* rects = builder.CreateGEP(batchesType, rectBatches, indices);
+                    llvm::Value* count = builder.CreateLoad(i32Type, getCountPtr(llvm::ConstantInt::get(i32Type, c)));
+                    llvm::Value* args[] = {rects, count, llvm::ConstantInt::get(i32Type, colors[c])};
+                    builder.CreateCall(fillRectsFunc, args);
+                }
             }
             else if (call->func == "flush") {
                 builder.CreateCall(flushFunc);
@@ -373,55 +424,11 @@ void generateIR(const std::vector<std::unique_ptr<ASM::Instruction>>& program, c
                 builder.CreateStore(result, resultPtr);
             }
             else if (call->func == "swap_buffers") {
-                // Генерация кода для обмена буферов
-                llvm::BasicBlock* swapYHeader = llvm::BasicBlock::Create(context, "swap_y_loop", mainFunc);
-                llvm::BasicBlock* swapYBody = llvm::BasicBlock::Create(context, "swap_y_body", mainFunc);
-                llvm::BasicBlock* swapYEnd = llvm::BasicBlock::Create(context, "swap_y_end", mainFunc);
-                llvm::BasicBlock* swapXHeader = llvm::BasicBlock::Create(context, "swap_x_loop", mainFunc);
-                llvm::BasicBlock* swapXBody = llvm::BasicBlock::Create(context, "swap_x_body", mainFunc);
-                llvm::BasicBlock* swapXEnd = llvm::BasicBlock::Create(context, "swap_x_end", mainFunc);
-                
-                // Внешний цикл по y
-                llvm::Value* yPtr = getRegPtr(0);
-                builder.CreateStore(llvm::ConstantInt::get(i32Type, 0), yPtr);
-                builder.CreateBr(swapYHeader);
-                
-                builder.SetInsertPoint(swapYHeader);
-                llvm::Value* y = builder.CreateLoad(i32Type, yPtr);
-                llvm::Value* yCond = builder.CreateICmpSLT(y, llvm::ConstantInt::get(i32Type, 64));
-                builder.CreateCondBr(yCond, swapYBody, swapYEnd);
-                
-                builder.SetInsertPoint(swapYBody);
-                llvm::Value* xPtr = getRegPtr(1);
-                builder.CreateStore(llvm::ConstantInt::get(i32Type, 0), xPtr);
-                builder.CreateBr(swapXHeader);
-                
-                // Внутренний цикл по x
-                builder.SetInsertPoint(swapXHeader);
-                llvm::Value* x = builder.CreateLoad(i32Type, xPtr);
-                llvm::Value* xCond = builder.CreateICmpSLT(x, llvm::ConstantInt::get(i32Type, 64));
-                builder.CreateCondBr(xCond, swapXBody, swapXEnd);
-                
-                // Тело внутреннего цикла - копирование next в current
-                builder.SetInsertPoint(swapXBody);
-                llvm::Value* nextPtr = getFieldPtr(next, y, x);
-                llvm::Value* currentPtr = getFieldPtr(current, y, x);
-                llvm::Value* nextVal = builder.CreateLoad(i32Type, nextPtr);
-                builder.CreateStore(nextVal, currentPtr);
-                
-                // Инкремент x
-                llvm::Value* xInc = builder.CreateAdd(x, llvm::ConstantInt::get(i32Type, 1));
-                builder.CreateStore(xInc, xPtr);
-                builder.CreateBr(swapXHeader);
-                
-                builder.SetInsertPoint(swapXEnd);
-                
-                // Инкремент y
-                llvm::Value* yInc = builder.CreateAdd(y, llvm::ConstantInt::get(i32Type, 1));
-                builder.CreateStore(yInc, yPtr);
-                builder.CreateBr(swapYHeader);
-                
-                builder.SetInsertPoint(swapYEnd);
+                // Обмен буферов - обмен указателей, ячейки не копируются
+                llvm::Value* currentVal = builder.CreateLoad(fieldPtrType, current);
+                llvm::Value* nextVal = builder.CreateLoad(fieldPtrType, next);
+                builder.CreateStore(nextVal, current);
+                builder.CreateStore(currentVal, next);
             }
         }
         else if (auto calc = dynamic_cast<ASM::CALC_NEIGHBORS*>(instr.get())) {
@@ -165,11 +165,7 @@ extern "C" void do_UPDATE_CELL(uint32_t y_reg, uint32_t x_reg) {
 
 extern "C" void do_SWAP_BUFFERS() {
     printf("do_SWAP_BUFFERS\n");
-    for (int y = 0; y < 64; y++) {
-        for (int x = 0; x < 64; x++) {
-            cpu.current[y][x] = cpu.next[y][x];
-        }
-    }
+    std::swap(cpu.current, cpu.next);
 }
 
 extern "C" void do_DRAW_FIELD() {
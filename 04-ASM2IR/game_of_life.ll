@@ -2,11 +2,14 @@
 source_filename = "game_of_life"
 
 @regs = common global [16 x i32] zeroinitializer
-@current = common global [64 x [64 x i32]] zeroinitializer
-@next = common global [64 x [64 x i32]] zeroinitializer
+@buffers = common global [2 x [64 x [64 x i32]]] zeroinitializer
+@current = internal global [64 x [64 x i32]]* getelementptr inbounds ([2 x [64 x [64 x i32]]], [2 x [64 x [64 x i32]]]* @buffers, i32 0, i32 0)
+@next = internal global [64 x [64 x i32]]* getelementptr inbounds ([2 x [64 x [64 x i32]]], [2 x [64 x [64 x i32]]]* @buffers, i32 0, i32 1)
 @temp = common global i32 0
+@rect_batches = internal global [3 x [4096 x [4 x i32]]] zeroinitializer
+@rect_counts = internal global [3 x i32] zeroinitializer
 
-declare void @simFillRect(i32, i32, i32, i32, i32)
+declare void @simFillRects([4 x i32]*, i32, i32)
 
 declare void @simFlush()
 
@@ -34,6 +37,9 @@ block_4:                                          ; preds = %block_3
   br label %block_5
 
 block_5:                                          ; preds = %block_21, %block_4
+  store i32 0, i32* getelementptr inbounds ([3 x i32], [3 x i32]* @rect_counts, i32 0, i32 0), align 4
+  store i32 0, i32* getelementptr inbounds ([3 x i32], [3 x i32]* @rect_counts, i32 0, i32 1), align 4
+  store i32 0, i32* getelementptr inbounds ([3 x i32], [3 x i32]* @rect_counts, i32 0, i32 2), align 4
   store i32 0, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
   br label %draw_y_loop
 
@@ -99,18 +105,21 @@ block_17:                                         ; preds = %block_16
   br i1 %15, label %block_9, label %block_18
 
 block_18:                                         ; preds = %block_17
-  store i32 0, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
-  br label %swap_y_loop
+  %16 = load [64 x [64 x i32]]*, [64 x [64 x i32]]** @current, align 8
+  %17 = load [64 x [64 x i32]]*, [64 x [64 x i32]]** @next, align 8
+  store [64 x [64 x i32]]* %17, [64 x [64 x i32]]** @current, align 8
+  store [64 x [64 x i32]]* %16, [64 x [64 x i32]]** @next, align 8
+  br label %block_19
 
-block_19:                                         ; preds = %swap_y_end
-  %16 = call i32 @checkFinish()
-  store i32 %16, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 15), align 4
+block_19:                                         ; preds = %block_18
+  %18 = call i32 @checkFinish()
+  store i32 %18, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 15), align 4
   br label %block_20
 
 block_20:                                         ; preds = %block_19
-  %17 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 15), align 4
-  %18 = icmp ne i32 %17, 0
-  br i1 %18, label %block_22, label %block_21
+  %19 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 15), align 4
+  %20 = icmp ne i32 %19, 0
+  br i1 %20, label %block_22, label %block_21
 
 block_21:                                         ; preds = %block_20
   br label %block_5
@@ -122,69 +131,56 @@ exit:                                             ; preds = %block_22
   ret void
 
 draw_y_loop:                                      ; preds = %draw_x_end, %block_5
-  %19 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
-  %20 = icmp slt i32 %19, 64
-  br i1 %20, label %draw_y_body, label %draw_y_end
+  %21 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
+  %22 = icmp slt i32 %21, 64
+  br i1 %22, label %draw_y_body, label %draw_y_end
 
 draw_y_body:                                      ; preds = %draw_y_loop
   store i32 0, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
   br label %draw_x_loop
 
 draw_y_end:                                       ; preds = %draw_y_loop
+  %23 = load i32, i32* getelementptr inbounds ([3 x i32], [3 x i32]* @rect_counts, i32 0, i32 0), align 4
+  call void @simFillRects([4 x i32]* getelementptr inbounds ([3 x [4096 x [4 x i32]]], [3 x [4096 x [4 x i32]]]* @rect_batches, i32 0, i32 0, i32 0), i32 %23, i32 0)
+  %24 = load i32, i32* getelementptr inbounds ([3 x i32], [3 x i32]* @rect_counts, i32 0, i32 1), align 4
+  call void @simFillRects([4 x i32]* getelementptr inbounds ([3 x [4096 x [4 x i32]]], [3 x [4096 x [4 x i32]]]* @rect_batches, i32 0, i32 1, i32 0), i32 %24, i32 13047173)
+  %25 = load i32, i32* getelementptr inbounds ([3 x i32], [3 x i32]* @rect_counts, i32 0, i32 2), align 4
+  call void @simFillRects([4 x i32]* getelementptr inbounds ([3 x [4096 x [4 x i32]]], [3 x [4096 x [4 x i32]]]* @rect_batches, i32 0, i32 2, i32 0), i32 %25, i32 65280)
   br label %block_6
 
 draw_x_loop:                                      ; preds = %draw_x_body, %draw_y_body
-  %21 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
-  %22 = icmp slt i32 %21, 64
-  br i1 %22, label %draw_x_body, label %draw_x_end
+  %26 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
+  %27 = icmp slt i32 %26, 64
+  br i1 %27, label %draw_x_body, label %draw_x_end
 
 draw_x_body:                                      ; preds = %draw_x_loop
-  %23 = getelementptr [64 x [64 x i32]], [64 x [64 x i32]]* @current, i32 0, i32 %19, i32 %21
-  %24 = load i32, i32* %23, align 4
-  %25 = icmp eq i32 %24, 1
-  %26 = icmp eq i32 %24, 2
-  %27 = select i1 %26, i32 65280, i32 0
-  %28 = select i1 %25, i32 13047173, i32 %27
-  %29 = mul i32 %21, 4
-  %30 = mul i32 %19, 4
-  call void @simFillRect(i32 %29, i32 %30, i32 4, i32 4, i32 %28)
-  %31 = add i32 %21, 1
-  store i32 %31, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
+  %28 = load [64 x [64 x i32]]*, [64 x [64 x i32]]** @current, align 8
+  %29 = getelementptr [64 x [64 x i32]], [64 x [64 x i32]]* %28, i32 0, i32 %21, i32 %26
+  %30 = load i32, i32* %29, align 4
+  %31 = icmp eq i32 %30, 1
+  %32 = icmp eq i32 %30, 2
+  %33 = select i1 %32, i32 2, i32 0
+  %34 = select i1 %31, i32 1, i32 %33
+  %35 = mul i32 %26, 4
+  %36 = mul i32 %21, 4
+  %37 = getelementptr [3 x i32], [3 x i32]* @rect_counts, i32 0, i32 %34
+  %38 = load i32, i32* %37, align 4
+  %39 = getelementptr [3 x [4096 x [4 x i32]]], [3 x [4096 x [4 x i32]]]* @rect_batches, i32 0, i32 %34, i32 %38, i32 0
+  store i32 %35, i32* %39, align 4
+  %40 = getelementptr [3 x [4096 x [4 x i32]]], [3 x [4096 x [4 x i32]]]* @rect_batches, i32 0, i32 %34, i32 %38, i32 1
+  store i32 %36, i32* %40, align 4
+  %41 = getelementptr [3 x [4096 x [4 x i32]]], [3 x [4096 x [4 x i32]]]* @rect_batches, i32 0, i32 %34, i32 %38, i32 2
+  store i32 4, i32* %41, align 4
+  %42 = getelementptr [3 x [4096 x [4 x i32]]], [3 x [4096 x [4 x i32]]]* @rect_batches, i32 0, i32 %34, i32 %38, i32 3
+  store i32 4, i32* %42, align 4
+  %43 = add i32 %38, 1
+  store i32 %43, i32* %37, align 4
+  %44 = add i32 %26, 1
+  store i32 %44, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
   br label %draw_x_loop
 
 draw_x_end:                                       ; preds = %draw_x_loop
-  %32 = add i32 %19, 1
-  store i32 %32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
+  %45 = add i32 %21, 1
+  store i32 %45, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
   br label %draw_y_loop
-
-swap_y_loop:                                      ; preds = %swap_x_end, %block_18
-  %33 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
-  %34 = icmp slt i32 %33, 64
-  br i1 %34, label %swap_y_body, label %swap_y_end
-
-swap_y_body:                                      ; preds = %swap_y_loop
-  store i32 0, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
-  br label %swap_x_loop
-
-swap_y_end:                                       ; preds = %swap_y_loop
-  br label %block_19
-
-swap_x_loop:                                      ; preds = %swap_x_body, %swap_y_body
-  %35 = load i32, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
-  %36 = icmp slt i32 %35, 64
-  br i1 %36, label %swap_x_body, label %swap_x_end
-
-swap_x_body:                                      ; preds = %swap_x_loop
-  %37 = getelementptr [64 x [64 x i32]], [64 x [64 x i32]]* @next, i32 0, i32 %33, i32 %35
-  %38 = getelementptr [64 x [64 x i32]], [64 x [64 x i32]]* @current, i32 0, i32 %33, i32 %35
-  %39 = load i32, i32* %37, align 4
-  store i32 %39, i32* %38, align 4
-  %40 = add i32 %35, 1
-  store i32 %40, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 1), align 4
-  br label %swap_x_loop
-
-swap_x_end:                                       ; preds = %swap_x_loop
-  %41 = add i32 %33, 1
-  store i32 %41, i32* getelementptr inbounds ([16 x i32], [16 x i32]* @regs, i32 0, i32 0), align 4
-  br label %swap_y_loop
 }
@@ -5,6 +5,7 @@
 #include <string>
 #include <functional>
 #include <unordered_map>
+#include <utility>
 #include "sim.h"
 
 namespace ASM {
@@ -16,9 +17,11 @@ namespace ASM {
         uint32_t pc = 0;
         bool running = true;
         
-        // Память для поля игры
-        uint32_t current[64][64] = {0};
-        uint32_t next[64][64] = {0};
+        // Память для поля игры: два буфера, current и next указывают на них
+        // и меняются местами в swap_buffers без копирования ячеек
+        uint32_t buffers[2][64][64] = {};
+        uint32_t (*current)[64] = buffers[0];
+        uint32_t (*next)[64] = buffers[1];
         
         // Временные переменные для вычислений
         uint32_t temp = 0;
@@ -310,26 +313,22 @@ namespace ASM {
                 }
             }
             else if (func == "draw_field") {
+                // Клетки группируются по цвету, на каждый цвет один вызов simFillRects
+                static const int colors[3] = {0x000000, 0xC71585, 0x00FF00};
+                static SimRect rects[3][64 * 64];
+                int count[3] = {0, 0, 0};
                 for (int y = 0; y < 64; y++) {
                     for (int x = 0; x < 64; x++) {
-                        int color;
-                        if (cpu.current[y][x] == 1) {
-                            color = 0xC71585;
-                        } else if (cpu.current[y][x] == 2) {
-                            color = 0x00FF00;
-                        } else {
-                            color = 0x000000;
-                        }
-                        simFillRect(x * 4, y * 4, 4, 4, color);
+                        int cell = cpu.current[y][x] <= 2 ? cpu.current[y][x] : 0;
+                        rects[cell][count[cell]++] = {x * 4, y * 4, 4, 4};
                     }
                 }
+                for (int c = 0; c < 3; c++) {
+                    simFillRects(rects[c], count[c], colors[c]);
+                }
             }
             else if (func == "swap_buffers") {
-                for (int y = 0; y < 64; y++) {
-                    for (int x = 0; x < 64; x++) {
-                        cpu.current[y][x] = cpu.next[y][x];
-                    }
-                }
+                std::swap(cpu.current, cpu.next);
             }
             else if (func == "flush") {
                 simFlush();
@@ -50,6 +50,15 @@ void simFillRect(int x, int y, int w, int h, int rgb) {
     SDL_RenderFillRect(Renderer, &rect);
 }
 
+void simFillRects(const SimRect *rects, int count, int rgb) {
+    Uint8 r = (rgb >> 16) & 0xFF;
+    Uint8 g = (rgb >> 8) & 0xFF;
+    Uint8 b = rgb & 0xFF;
+    SDL_SetRenderDrawColor(Renderer, r, g, b, 255);
+    /* SimRect has the same layout as SDL_Rect */
+    SDL_RenderFillRects(Renderer, (const SDL_Rect *)rects, count);
+}
+
 int simRand() {
     return rand();
 }
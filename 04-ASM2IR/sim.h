@@ -44,11 +44,20 @@
 
 #ifndef __sim__
 #define __sim__
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} SimRect;
+
 void simInit();
 void app();
 void simExit();
 void simFlush();
 void simFillRect(int x, int y, int w, int h, int rgb);
+/* Fills count rectangles with one color, callers group their rectangles by color. */
+void simFillRects(const SimRect *rects, int count, int rgb);
 int simRand();
 int simGetTicks();
 void simDelay(int ms);
@@ -1,11 +1,20 @@
 #ifndef LIFELANG_SIM_H
 #define LIFELANG_SIM_H
 
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} SimRect;
+
 void simInit();
 void simExit();
 void simFlush();
 void simPutPixel(int x, int y, int rgb);
 void simFillRect(int x, int y, int w, int h, int rgb);
+/* Fills count rectangles with one color, after any queued simFillRect() calls. */
+void simFillRects(const SimRect *rects, int count, int rgb);
 int  simRand();
 int  simGetTicks();
 void simDelay(int ms);
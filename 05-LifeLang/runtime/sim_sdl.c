@@ -14,6 +14,33 @@
 static SDL_Renderer *Renderer = NULL;
 static SDL_Window *Window = NULL;
 
+/*
+ * fill_rect() calls of one color in a row are queued and drawn with one
+ * SDL_RenderFillRects when the color changes, the batch fills up, anything
+ * else is drawn or the frame is flushed. Draws keep their order.
+ */
+#define BATCH_SIZE 4096
+
+static SimRect Batch[BATCH_SIZE];
+static int BatchCount = 0;
+static int BatchRgb = 0;
+
+static void fillRects(const SimRect *rects, int count, int rgb) {
+    Uint8 r = (rgb >> 16) & 0xFF;
+    Uint8 g = (rgb >> 8) & 0xFF;
+    Uint8 b = rgb & 0xFF;
+    SDL_SetRenderDrawColor(Renderer, r, g, b, 255);
+    /* SimRect has the same layout as SDL_Rect */
+    SDL_RenderFillRects(Renderer, (const SDL_Rect *)rects, count);
+}
+
+static void drawBatch() {
+    if (BatchCount) {
+        fillRects(Batch, BatchCount, BatchRgb);
+        BatchCount = 0;
+    }
+}
+
 void simInit() {
     SDL_Init(SDL_INIT_VIDEO);
     SDL_CreateWindowAndRenderer(SIM_X_SIZE, SIM_Y_SIZE, 0, &Window, &Renderer);
@@ -36,6 +63,7 @@ void simExit() {
 }
 
 void simFlush() {
+    drawBatch();
     SDL_PumpEvents();
     SDL_RenderPresent(Renderer);
 }
@@ -43,6 +71,7 @@ void simFlush() {
 void simPutPixel(int x, int y, int rgb) {
     assert(0 <= x && x < SIM_X_SIZE);
     assert(0 <= y && y < SIM_Y_SIZE);
+    drawBatch();
     Uint8 r = (rgb >> 16) & 0xFF;
     Uint8 g = (rgb >> 8) & 0xFF;
     Uint8 b = rgb & 0xFF;
@@ -53,12 +82,20 @@ void simPutPixel(int x, int y, int rgb) {
 void simFillRect(int x, int y, int w, int h, int rgb) {
     assert(0 <= x && x + w <= SIM_X_SIZE);
     assert(0 <= y && y + h <= SIM_Y_SIZE);
-    Uint8 r = (rgb >> 16) & 0xFF;
-    Uint8 g = (rgb >> 8) & 0xFF;
-    Uint8 b = rgb & 0xFF;
-    SDL_SetRenderDrawColor(Renderer, r, g, b, 255);
-    SDL_Rect rect = {x, y, w, h};
-    SDL_RenderFillRect(Renderer, &rect);
+    if (BatchCount == BATCH_SIZE || (BatchCount && BatchRgb != rgb)) {
+        drawBatch();
+    }
+    BatchRgb = rgb;
+    SimRect *rect = &Batch[BatchCount++];
+    rect->x = x;
+    rect->y = y;
+    rect->w = w;
+    rect->h = h;
+}
+
+void simFillRects(const SimRect *rects, int count, int rgb) {
+    drawBatch();
+    fillRects(rects, count, rgb);
 }
 
 int simRand() { return rand(); }
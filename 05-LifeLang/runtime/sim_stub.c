@@ -7,6 +7,7 @@ void simExit() { }
 void simFlush() { }
 void simPutPixel(int x, int y, int rgb) { (void)x; (void)y; (void)rgb; }
 void simFillRect(int x, int y, int w, int h, int rgb) { (void)x; (void)y; (void)w; (void)h; (void)rgb; }
+void simFillRects(const SimRect *rects, int count, int rgb) { (void)rects; (void)count; (void)rgb; }
 int  simRand() { return rand(); }
 int  simGetTicks() { return 0; }
 void simDelay(int ms) { (void)ms; }
@@ -85,3 +85,5 @@ void BreakStmt::codegen(CodeGen& cg) { cg.codegenBreak(); }
 void ContinueStmt::codegen(CodeGen& cg) { cg.codegenContinue(); }
 
 void ReturnStmt::codegen(CodeGen& cg) { cg.codegenReturn(value); }
+
+void SwapStmt::codegen(CodeGen& cg) { cg.codegenSwap(a, b); }
@@ -168,6 +168,13 @@ struct ReturnStmt : Stmt {
     void codegen(CodeGen& cg) override;
 };
 
+struct SwapStmt : Stmt {
+    std::string a;
+    std::string b;
+    SwapStmt(std::string x, std::string y) : a(std::move(x)), b(std::move(y)) {}
+    void codegen(CodeGen& cg) override;
+};
+
 
 struct ConstDecl : Decl {
     std::string name;
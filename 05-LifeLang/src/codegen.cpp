@@ -231,7 +231,8 @@ Value* CodeGen::addrOfIndex(const std::string& base, const std::vector<Expr*>& i
     }
 
     Type* arrTy = arrayTypeFromDims(vi->dims);
-    return builder.CreateInBoundsGEP(arrTy, vi->alloca, gepIdx, base + ".elt");
+    Value* arr = builder.CreateLoad(PointerType::getUnqual(arrTy), vi->alloca, base + ".arr");
+    return builder.CreateInBoundsGEP(arrTy, arr, gepIdx, base + ".elt");
 }
 
 Value* CodeGen::codegenUnary(const std::string& op, Expr* rhsE) {
@@ -377,6 +378,7 @@ void CodeGen::codegenVarDecl(const std::string& name, const std::vector<Expr*>&
         cgError("redeclared variable '" + name + "' in same scope");
 
     VarInfo vi;
+    vi.depth = scopes.size() - 1;
 
     if (dimsE.empty()) {
         vi.alloca = createEntryAlloca(fn, i32Ty(), name);
@@ -402,12 +404,15 @@ void CodeGen::codegenVarDecl(const std::string& name, const std::vector<Expr*>&
     }
 
     Type* arrTy = arrayTypeFromDims(dims);
-    vi.alloca = createEntryAlloca(fn, arrTy, name);
+    vi.storage = createEntryAlloca(fn, arrTy, name + ".data");
+    vi.storage->setAlignment(Align(16));
+    vi.alloca = createEntryAlloca(fn, PointerType::getUnqual(arrTy), name);
     vi.dims = dims;
     cur[name] = vi;
+    builder.CreateStore(vi.storage, vi.alloca);
 
     int64_t bytes = totalElems * 4;
-    Value* i8ptr = builder.CreateBitCast(vi.alloca, Type::getInt8PtrTy(ctx), name + ".i8");
+    Value* i8ptr = builder.CreateBitCast(vi.storage, Type::getInt8PtrTy(ctx), name + ".i8");
     builder.CreateMemSet(i8ptr, builder.getInt8(0), (uint64_t)bytes, MaybeAlign(16));
 
     if (initE)
@@ -545,3 +550,39 @@ void CodeGen::codegenReturn(Expr* valueE) {
     BasicBlock* after = BasicBlock::Create(ctx, "after.return", fn);
     builder.SetInsertPoint(after);
 }
+
+void CodeGen::codegenSwap(const std::string& a, const std::string& b) {
+    VarInfo* va = findVar(a);
+    VarInfo* vb = findVar(b);
+    if (!va) 
+        cgError("unknown variable '" + a + "'");
+    if (!vb) 
+        cgError("unknown variable '" + b + "'");
+    if (va->dims != vb->dims) 
+        cgError("cannot swap '" + a + "' and '" + b + "' of different shapes");
+
+    // Arrays of different scopes swap elements: a pointer swap would leave the outer
+    // array on the inner one's storage, which its declaration zeroes when it runs again.
+    if (!va->dims.empty() && va->depth != vb->depth) {
+        Type* arrTy = arrayTypeFromDims(va->dims);
+        Type* ptrTy = PointerType::getUnqual(arrTy);
+        uint64_t bytes = 4;
+        for (int64_t d : va->dims)
+            bytes *= (uint64_t)d;
+        AllocaInst* tmp = createEntryAlloca(builder.GetInsertBlock()->getParent(), arrTy, "swap.tmp");
+        tmp->setAlignment(Align(16));
+        Value* ap = builder.CreateLoad(ptrTy, va->alloca, a + ".swp");
+        Value* bp = builder.CreateLoad(ptrTy, vb->alloca, b + ".swp");
+        builder.CreateMemCpy(tmp, MaybeAlign(16), ap, MaybeAlign(16), bytes);
+        builder.CreateMemCpy(ap, MaybeAlign(16), bp, MaybeAlign(16), bytes);
+        builder.CreateMemCpy(bp, MaybeAlign(16), tmp, MaybeAlign(16), bytes);
+        return;
+    }
+
+    // Scalars swap values, arrays of the same scope swap their storage pointers.
+    Type* ty = va->dims.empty() ? i32Ty() : PointerType::getUnqual(arrayTypeFromDims(va->dims));
+    Value* av = builder.CreateLoad(ty, va->alloca, a + ".swp");
+    Value* bv = builder.CreateLoad(ty, vb->alloca, b + ".swp");
+    builder.CreateStore(bv, va->alloca);
+    builder.CreateStore(av, vb->alloca);
+}
@@ -17,9 +17,15 @@
 
 namespace lifelang {
 
+// For arrays `alloca` is a slot holding a pointer to the array storage,
+// so `swap a, b;` exchanges two arrays without copying their elements.
+// `depth` is the index of the declaring scope: only arrays of the same
+// scope swap pointers, see codegenSwap.
 struct VarInfo {
     llvm::AllocaInst* alloca = nullptr;
+    llvm::AllocaInst* storage = nullptr;
     std::vector<int64_t> dims; 
+    size_t depth = 0;
 };
 
 struct LoopTarget {
@@ -92,6 +98,7 @@ struct CodeGen {
     void codegenBreak();
     void codegenContinue();
     void codegenReturn(Expr* value);
+    void codegenSwap(const std::string& a, const std::string& b);
 };
 
 } // namespace lifelang
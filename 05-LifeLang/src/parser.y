@@ -53,6 +53,7 @@ static std::string takeStr(char* s) { std::string r(s); free(s); return r; }
 %token KW_WHILE KW_FOR
 %token KW_BREAK KW_CONTINUE
 %token KW_RETURN
+%token KW_SWAP
 %token KW_I32 KW_VOID
 
 %token OP_EQ OP_NE OP_LE OP_GE OP_AND OP_OR
@@ -62,7 +63,7 @@ static std::string takeStr(char* s) { std::string r(s); free(s); return r; }
 %type <rtype> ReturnOpt TypeSpec
 %type <block> Block
 %type <stmts> StmtList
-%type <stmt>  Stmt VarDecl AssignStmt IfStmt WhileStmt ForStmt BreakStmt ContinueStmt ReturnStmt ExprStmt
+%type <stmt>  Stmt VarDecl AssignStmt IfStmt WhileStmt ForStmt BreakStmt ContinueStmt ReturnStmt SwapStmt ExprStmt
 %type <stmt>  ForInit ForStep
 %type <expr>  Expr ExprOpt OrExpr AndExpr EqExpr RelExpr AddExpr MulExpr Unary Primary LValue
 %type <exprs> ArgListOpt ArgList IndexList DimListOpt DimList
@@ -137,6 +138,7 @@ Stmt
   | BreakStmt      { $$ = $1; }
   | ContinueStmt   { $$ = $1; }
   | ReturnStmt     { $$ = $1; }
+  | SwapStmt       { $$ = $1; }
   | ExprStmt       { $$ = $1; }
   | Block          { $$ = $1; }
   ;
@@ -220,6 +222,12 @@ ReturnStmt
   | KW_RETURN Expr ';' { $$ = new ReturnStmt($2); }
   ;
 
+SwapStmt
+  : KW_SWAP IDENT ',' IDENT ';' {
+      $$ = new SwapStmt(takeStr($2), takeStr($4));
+    }
+  ;
+
 ExprStmt
   : Expr ';' { $$ = new ExprStmt($1); }
   ;